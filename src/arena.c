@@ -0,0 +1,68 @@
+#include "arena.h"
+
+#include <stdalign.h>
+#include <string.h>
+
+
+#define ARENA_ALIGNMENT     alignof(max_align_t)
+#define ALIGN_UP(x)         (((x) + (ARENA_ALIGNMENT - 1)) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+struct ic_arena_block
+{
+    ic_arena_block_t *next;
+    size_t size;   /* of 'data' */
+    size_t used;
+    alignas(max_align_t) uint8_t data[];
+};
+
+
+void *
+arena_alloc(ic_arena_t *arena, size_t count, size_t size)
+{
+    if (0 != size && count > (SIZE_MAX - ARENA_ALIGNMENT) / size) return NULL;
+
+    size_t length = ALIGN_UP(count * size);
+    ic_arena_block_t *block = arena->blocks;
+
+    if (NULL == block || block->size - block->used < length) {
+        /* Whatever is left of the old block is wasted; it's never more than one allocation's worth. */
+        size_t block_size = MAX(IC_ARENA_BLOCK_SIZE - sizeof(ic_arena_block_t), length);
+
+        /* Not calloc: only the parts actually handed out get touched (and faulted in), not the whole block. */
+        block = malloc(sizeof(ic_arena_block_t) + block_size);
+        if (NULL == block) return NULL;
+
+        block->next = arena->blocks;
+        block->size = block_size;
+        block->used = 0;
+        arena->blocks = block;
+    }
+
+    void *allocation = &block->data[block->used];
+    block->used += length;
+
+    return memset(allocation, 0, length);
+}
+
+
+char *
+arena_strdup(ic_arena_t *arena, const char *text)
+{
+    size_t length = strlen(text) + 1;
+
+    char *copy = arena_alloc(arena, length, sizeof(char));
+    if (NULL == copy) return NULL;
+
+    return memcpy(copy, text, length);
+}
+
+
+void
+arena_release(ic_arena_t *arena)
+{
+    while (NULL != arena->blocks) {
+        ic_arena_block_t *next = arena->blocks->next;
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+}
@@ -2,7 +2,11 @@
 // Created by puhlz on 5/28/25.
 //
 
+/* Needed for 'recvmmsg'. */
+#define _GNU_SOURCE
+
 #include "canbus.h"
+#include "latency.h"
 
 /* We assume Linux for this, but this can easily be replaced with your own CAN definitions. */
 #include <stddef.h>
@@ -11,17 +15,112 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
+#include <sys/time.h>
 #include <errno.h>
+#include <inttypes.h>
 #include <pthread.h>
 #include <string.h>
 #include <stdio.h>
 #include <net/if.h>
 #include <linux/can.h>
 #include <linux/can/raw.h>
+#if IC_OPT_CAN_INGEST_RING==1
+#include <semaphore.h>
+#endif   /* IC_OPT_CAN_INGEST_RING */
+
+
+/*
+ * Receive buffers are sized for the frame types the build accepts. Classic-only builds read plain
+ *  16-byte 'can_frame's; FD builds read 72-byte 'canfd_frame's, which classic frames also fit into.
+ */
+#if IC_OPT_CAN_FD_EXTENDED==1
+typedef struct canfd_frame ic_can_frame_t;
+#else   /* IC_OPT_CAN_FD_EXTENDED */
+typedef struct can_frame ic_can_frame_t;
+#endif   /* IC_OPT_CAN_FD_EXTENDED */
+
 
+static void
+process_can_frame(canbus_thread_ctx_t *ctx, ic_can_frame_t *frame);
+
+static inline bool
+is_complete_frame(const ic_can_frame_t *frame, ssize_t bytes_received);
 
+#if IC_OPT_CAN_BATCH_RECV==1
 static void
-process_can_frame(struct canfd_frame *frame, ssize_t bytes_received);
+process_can_frames(canbus_thread_ctx_t *ctx, ic_can_frame_t *frames, struct mmsghdr *msgs, int count);
+#endif   /* IC_OPT_CAN_BATCH_RECV */
+
+
+/* The last raw payload received for each DBC message (indexed like 'DBC.messages'). */
+#if IC_OPT_CAN_FD_EXTENDED==1
+static uint8_t last_payloads[DBC_MESSAGES_LEN][CANFD_MAX_DLEN];
+#else   /* IC_OPT_CAN_FD_EXTENDED */
+static uint8_t last_payloads[DBC_MESSAGES_LEN][CAN_MAX_DLEN];
+#endif   /* IC_OPT_CAN_FD_EXTENDED */
+static bool has_last_payload[DBC_MESSAGES_LEN] = {0};
+
+/*
+ * The bus index each DBC message is decoded from, or -1 when no bus carries it. Every message has
+ *  at most one owning listener, which keeps each signal's seqlock single-writer.
+ */
+static int message_bus[DBC_MESSAGES_LEN];
+
+
+#if IC_OPT_LATENCY_TRACKING==1
+_Thread_local uint64_t can_rx_time_ns = 0;
+
+/* Room for the single SCM_TIMESTAMPNS control message delivered with every received frame. */
+#define RX_CONTROL_SIZE CMSG_SPACE(sizeof(struct timespec))
+
+static inline uint64_t
+rx_timestamp(struct msghdr *header);
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+
+#if IC_OPT_CAN_INGEST_RING==1
+#define IC_CACHE_LINE 64
+
+/*
+ * Single-producer, single-consumer frame queue between a bus's socket reader and its decoder. The
+ *  indices only ever grow; slots are addressed modulo the (power-of-two) depth. Each side's index
+ *  sits on its own cache line, next to a private copy of the other side's index, so the two threads
+ *  only share a line when one of them actually has to re-check the other's progress.
+ */
+typedef
+struct {
+    _Alignas(IC_CACHE_LINE) atomic_size_t head;   /* next slot to fill; written by the reader */
+    size_t pending_head;   /* reader-private: slots filled but not yet published */
+    size_t cached_tail;   /* reader-private */
+
+    _Alignas(IC_CACHE_LINE) atomic_size_t tail;   /* next slot to drain; written by the decoder */
+    size_t cached_head;   /* decoder-private */
+
+    _Alignas(IC_CACHE_LINE) sem_t pending;   /* posted once per published batch */
+
+    _Alignas(IC_CACHE_LINE) ic_can_frame_t frames[IC_OPT_CAN_RING_DEPTH];
+#if IC_OPT_LATENCY_TRACKING==1
+    uint64_t rx_times_ns[IC_OPT_CAN_RING_DEPTH];   /* receive timestamp of each slot's frame */
+#endif   /* IC_OPT_LATENCY_TRACKING */
+} ingest_ring_t;
+
+static ingest_ring_t ingest_rings[IC_OPT_CAN_NUM_BUSES];
+
+static inline void
+ring_push(canbus_thread_ctx_t *ctx, const ic_can_frame_t *frame);
+
+static inline void
+ring_publish(canbus_thread_ctx_t *ctx);
+
+static void *
+canbus_decoder(void *context);
+#endif   /* IC_OPT_CAN_INGEST_RING */
+
+
+#if IC_OPT_CAN_ID_FILTER==1
+static ic_err_t
+install_id_filters(int s_fd, int bus_index);
+#endif   /* IC_OPT_CAN_ID_FILTER */
 
 
 #if IC_OPT_ID_MAPPING==1
@@ -40,33 +139,92 @@ create_dbc_id_map();
 
 static ic_err_t
 lookup_dbc_msg_by_id(canid_t id, const dbc_message_t **out);
+#elif IC_OPT_ID_MAPPING==2
+static inline const dbc_message_t *
+lookup_sorted_dbc_msg_by_id(canid_t id);
 #endif   /* IC_OPT_ID_MAPPING */
 
 
+static const dbc_message_t *
+find_dbc_msg_by_name(const char *name)
+{
+    for (int i = 0; i < DBC_MESSAGES_LEN; ++i)
+        if (0 == strcmp(DBC.messages[i].name, name)) return &DBC.messages[i];
+
+    return NULL;
+}
+
+
+ic_err_t
+canbus_init(void)
+{
+    const ic_can_bus_opts_t *buses = compile_time_ic_options.can.buses;
+    ic_err_t create_map_response;
+
+    /* Map loaded DBC message pointers to the incoming ID. This should be O(1) rather than O(N). */
+#if IC_OPT_ID_MAPPING==1
+    if (ERR_OK != (create_map_response = create_dbc_id_map())) {
+        fprintf(stderr, "ERROR:  Failed to initialize the ID-to-DBC message map.\n");
+        return create_map_response;
+    }
+#endif   /* IC_OPT_ID_MAPPING */
+
+    for (int i = 0; i < DBC_MESSAGES_LEN; ++i) message_bus[i] = -1;
+
+    /* Explicitly listed messages first... */
+    for (int b = 0; b < compile_time_ic_options.can.num_buses; ++b) {
+        if (NULL == buses[b].message_names) continue;
+
+        for (const char **name = buses[b].message_names; NULL != *name; ++name) {
+            const dbc_message_t *message = find_dbc_msg_by_name(*name);
+
+            if (NULL == message) {
+                fprintf(stderr, "ERROR:  Bus '%s' lists unknown DBC message '%s'.\n", buses[b].interface_name, *name);
+                return ERR_CAN_BUS_ASSIGNMENT;
+            }
+
+            if (-1 != message_bus[message - DBC.messages]) {
+                fprintf(stderr, "ERROR:  DBC message '%s' is assigned to more than one bus.\n", *name);
+                return ERR_CAN_BUS_ASSIGNMENT;
+            }
+
+            message_bus[message - DBC.messages] = b;
+        }
+    }
+
+    /* ... then a bus without a list takes everything left over. */
+    for (int b = 0; b < compile_time_ic_options.can.num_buses; ++b) {
+        if (NULL != buses[b].message_names) continue;
+
+        for (int i = 0; i < DBC_MESSAGES_LEN; ++i)
+            if (-1 == message_bus[i]) message_bus[i] = b;
+
+        break;
+    }
+
+    for (int i = 0; i < DBC_MESSAGES_LEN; ++i) {
+        DPRINTLN(
+            "DBC message '%s' is received from '%s'.", DBC.messages[i].name,
+            -1 == message_bus[i] ? "(no bus)" : buses[message_bus[i]].interface_name
+        );
+    }
+
+    return ERR_OK;
+}
+
+
 void *
 canbus_listener(void *context)
 {
     int s_fd;   /* CAN socket file descriptor. */
     struct sockaddr_can address = {0};
     struct ifreq ifr;
-    struct canfd_frame frame = {0};
-    ssize_t num_bytes = 0;
     canbus_thread_ctx_t *ctx;
-    ic_err_t create_map_response;
 
     /* Cast incoming structure. */
     ctx = (canbus_thread_ctx_t *)context;
     ctx->thread_status = ERR_OK;   /* assert this condition, even though the caller should set it before start */
 
-    /* Map loaded DBC message pointers to the incoming ID. This should be O(1) rather than O(N). */
-#if IC_OPT_ID_MAPPING==1
-    if (ERR_OK != (create_map_response = create_dbc_id_map())) {
-        fprintf(stderr, "ERROR:  Failed to initialize the ID-to-DBC message map.\n");
-        ctx->thread_status = create_map_response;
-        return NULL;
-    }
-#endif   /* IC_OPT_ID_MAPPING */
-
     /* Create the CAN listener/socket and bind it. */
     s_fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
     if (s_fd < 0) {
@@ -75,6 +233,14 @@ canbus_listener(void *context)
         return NULL;
     }
 
+#if IC_OPT_CAN_ID_FILTER==1
+    /* Only let frames which somebody actually displays cross into userspace. */
+    if (ERR_OK != (ctx->thread_status = install_id_filters(s_fd, ctx->bus_index))) {
+        close(s_fd);
+        return NULL;
+    }
+#endif   /* IC_OPT_CAN_ID_FILTER */
+
     /* Use the passed interface name. The system should already have one set up according to the README. */
     strcpy(ifr.ifr_name, ctx->can_if_name);
     if (ioctl(s_fd, SIOCGIFINDEX, &ifr) < 0) {
@@ -92,6 +258,92 @@ canbus_listener(void *context)
         return NULL;
     }
 
+#if IC_OPT_CAN_FD_EXTENDED==1
+    /* Ask for FD frames too. Classic frames keep arriving as CAN_MTU-sized reads. */
+    int enable_fd_frames = 1;
+    if (setsockopt(s_fd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable_fd_frames, sizeof(enable_fd_frames)) < 0) {
+        perror("setsockopt");
+        close(s_fd);
+        ctx->thread_status = ERR_CAN_SOCKET;
+        return NULL;
+    }
+
+    /* Not fatal: an interface without FD support just never delivers FD frames. This reuses 'ifr',
+     *  whose index shares a union with the MTU, so it must come after the bind. */
+    if (ioctl(s_fd, SIOCGIFMTU, &ifr) < 0 || CANFD_MTU != ifr.ifr_mtu) {
+        fprintf(stderr, "WARNING:  CAN interface '%s' is not CAN FD capable. Only classic frames will be received.\n", ctx->can_if_name);
+    }
+#endif   /* IC_OPT_CAN_FD_EXTENDED */
+
+#if IC_OPT_LATENCY_TRACKING==1
+    /*
+     * Have the kernel stamp every frame as it is received. Hardware timestamps (SO_TIMESTAMPING) run
+     *  on the controller's own clock, which the render thread can't compare against, so use these.
+     */
+    int enable_timestamps = 1;
+    if (setsockopt(s_fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable_timestamps, sizeof(enable_timestamps)) < 0) {
+        perror("setsockopt");
+        close(s_fd);
+        ctx->thread_status = ERR_CAN_SOCKET;
+        return NULL;
+    }
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+#if IC_OPT_CAN_BATCH_RECV==1
+    /* Let a quiet bus wake the listener periodically, so 'should_close' is still honored. */
+    struct timeval recv_timeout = {
+        .tv_sec = compile_time_ic_options.can.batch_timeout_us / 1000000,
+        .tv_usec = compile_time_ic_options.can.batch_timeout_us % 1000000
+    };
+    if (setsockopt(s_fd, SOL_SOCKET, SO_RCVTIMEO, &recv_timeout, sizeof(recv_timeout)) < 0) {
+        perror("setsockopt");
+        close(s_fd);
+        ctx->thread_status = ERR_CAN_SOCKET;
+        return NULL;
+    }
+
+    /* Each batch slot receives exactly one frame through its own I/O vector. */
+    ic_can_frame_t frames[IC_OPT_CAN_BATCH_DEPTH] = {0};
+    struct iovec iovecs[IC_OPT_CAN_BATCH_DEPTH];
+    struct mmsghdr msgs[IC_OPT_CAN_BATCH_DEPTH] = {0};
+    int num_frames = 0;
+#if IC_OPT_LATENCY_TRACKING==1
+    uint8_t rx_controls[IC_OPT_CAN_BATCH_DEPTH][RX_CONTROL_SIZE];
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+    for (int i = 0; i < IC_OPT_CAN_BATCH_DEPTH; ++i) {
+        iovecs[i].iov_base = &frames[i];
+        iovecs[i].iov_len = sizeof(ic_can_frame_t);
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+#if IC_OPT_LATENCY_TRACKING==1
+        msgs[i].msg_hdr.msg_control = rx_controls[i];
+#endif   /* IC_OPT_LATENCY_TRACKING */
+    }
+#else   /* IC_OPT_CAN_BATCH_RECV */
+    ic_can_frame_t frame = {0};
+    ssize_t num_bytes = 0;
+#if IC_OPT_LATENCY_TRACKING==1
+    /* Timestamps arrive as control messages, which plain 'read' can't return. */
+    uint8_t rx_control[RX_CONTROL_SIZE];
+    struct iovec iovec = { .iov_base = &frame, .iov_len = sizeof(ic_can_frame_t) };
+    struct msghdr msg = { .msg_iov = &iovec, .msg_iovlen = 1, .msg_control = rx_control };
+#endif   /* IC_OPT_LATENCY_TRACKING */
+#endif   /* IC_OPT_CAN_BATCH_RECV */
+
+#if IC_OPT_CAN_INGEST_RING==1
+    /* Decoding moves to its own thread, so a slow decode can never hold up draining the socket. */
+    pthread_t decoder_thread;
+    ingest_ring_t *ring = &ingest_rings[ctx->bus_index];
+
+    if (0 != sem_init(&ring->pending, 0, 0) || 0 != pthread_create(&decoder_thread, NULL, canbus_decoder, ctx)) {
+        fprintf(stderr, "ERROR:  Failed to start the CAN decoder thread for '%s'.\n", ctx->can_if_name);
+        close(s_fd);
+        ctx->thread_status = ERR_OUT_OF_RESOURCES;
+        return NULL;
+    }
+#endif   /* IC_OPT_CAN_INGEST_RING */
+
     /* Indicate everything is ready. */
     ctx->thread_status = ERR_CAN_LISTENING;
     ctx->is_listening = true;
@@ -104,7 +356,38 @@ canbus_listener(void *context)
             break;
         }
 
-        num_bytes = read(s_fd, &frame, sizeof(struct canfd_frame));
+#if IC_OPT_CAN_BATCH_RECV==1
+#if IC_OPT_LATENCY_TRACKING==1
+        /* The kernel shrinks each control length to what it wrote, so give every slot its full room back. */
+        for (int i = 0; i < IC_OPT_CAN_BATCH_DEPTH; ++i) msgs[i].msg_hdr.msg_controllen = RX_CONTROL_SIZE;
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+        /* Block for the first frame, then take whatever else is already queued (up to the batch depth). */
+        num_frames = recvmmsg(s_fd, msgs, IC_OPT_CAN_BATCH_DEPTH, MSG_WAITFORONE, NULL);
+        ++ctx->recv_calls;
+
+        if (num_frames < 0) {
+            if (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno) continue;
+
+            perror("recvmmsg");
+            ctx->thread_status = ERR_CAN_CLOSED;
+            break;
+        }
+
+        ctx->frames_received += num_frames;
+        process_can_frames(ctx, frames, msgs, num_frames);
+#if IC_OPT_CAN_INGEST_RING==1
+        ring_publish(ctx);
+#endif   /* IC_OPT_CAN_INGEST_RING */
+#else   /* IC_OPT_CAN_BATCH_RECV */
+#if IC_OPT_LATENCY_TRACKING==1
+        msg.msg_controllen = RX_CONTROL_SIZE;
+        num_bytes = recvmsg(s_fd, &msg, 0);
+        can_rx_time_ns = rx_timestamp(&msg);
+#else   /* IC_OPT_LATENCY_TRACKING */
+        num_bytes = read(s_fd, &frame, sizeof(ic_can_frame_t));
+#endif   /* IC_OPT_LATENCY_TRACKING */
+        ++ctx->recv_calls;
 
         if (!num_bytes) {
             perror("read");
@@ -112,22 +395,45 @@ canbus_listener(void *context)
             break;
         }
 
-        if (
-            num_bytes < 9   /* minimum size of at least the prelude of a CAN message, plus 1 byte */
-            || num_bytes < 8 + frame.len   /* If we do have a len, needs to match what was received */
-        ) {
-            fprintf(stderr, "Hmm. Received an incomplete CAN frame. Skipping.\n");
+        ++ctx->frames_received;
+        if (!is_complete_frame(&frame, num_bytes)) {
+            ++ctx->frames_incomplete;
             continue;
         }
-#if IC_OPT_DISABLE_CAN_DETAILS!=1
-        DPRINTLN("Received CAN frame with ID 0x%X.", frame.can_id);
-        DPRINT("Data: "); MEMDUMP(frame.data, frame.len);
-#endif   /* IC_OPT_DISABLE_CAN_DETAILS */
 
         /* Now do something with the CAN frame. */
-        process_can_frame(&frame, num_bytes);
+#if IC_OPT_CAN_INGEST_RING==1
+        ring_push(ctx, &frame);
+        ring_publish(ctx);
+#else   /* IC_OPT_CAN_INGEST_RING */
+        process_can_frame(ctx, &frame);
+#endif   /* IC_OPT_CAN_INGEST_RING */
+#endif   /* IC_OPT_CAN_BATCH_RECV */
+
+#if IC_DEBUG==1 && IC_OPT_DISABLE_CAN_DETAILS!=1
+        if (0 == (ctx->recv_calls % 4096)) {
+            DPRINTLN(
+                ">>> CAN ingest on '%s': %" PRIu64 " frames over %" PRIu64 " receive syscalls (%f frames/call), %" PRIu64 " decoded, %" PRIu64 " dropped, %" PRIu64 " incomplete.",
+                ctx->can_if_name, ctx->frames_received, ctx->recv_calls,
+                (double)ctx->frames_received / (double)ctx->recv_calls, ctx->frames_decoded, ctx->frames_dropped,
+                ctx->frames_incomplete
+            );
+#if IC_OPT_CAN_INGEST_RING==1
+            DPRINTLN(
+                ">>> CAN ingest ring on '%s': high-water mark %u/%u, %" PRIu64 " overflow(s).",
+                ctx->can_if_name, ctx->ring_high_water, IC_OPT_CAN_RING_DEPTH, ctx->ring_overflows
+            );
+#endif   /* IC_OPT_CAN_INGEST_RING */
+        }
+#endif   /* IC_DEBUG */
     }
 
+#if IC_OPT_CAN_INGEST_RING==1
+    /* 'thread_status' is no longer LISTENING, so one last wake-up lets the decoder exit. */
+    sem_post(&ring->pending);
+    pthread_join(decoder_thread, NULL);
+#endif   /* IC_OPT_CAN_INGEST_RING */
+
     close(s_fd);
     ctx->is_listening = false;
 
@@ -144,24 +450,163 @@ canbus_status(const ic_err_t status)
         case ERR_CAN_CLOSED: return "CAN CLOSED";
         case ERR_CAN_INVALID_CONTEXT: return "CAN INVALID CONTEXT";
         case ERR_CAN_IOCTL: return "CAN IOCTL";
+        case ERR_CAN_FILTER: return "CAN FILTER";
+        case ERR_CAN_BUS_ASSIGNMENT: return "CAN BUS ASSIGNMENT";
         case ERR_CAN_SOCKET: return "CAN SOCKET";
         default: return "Unknown error";
     }
 }
 
 
+static inline bool
+is_complete_frame(const ic_can_frame_t *frame, ssize_t bytes_received)
+{
+    /* The kernel always delivers whole frames, so the read size tells classic and FD frames apart. */
+    if (
+        !(CAN_MTU == bytes_received && frame->len <= CAN_MAX_DLEN)
+#if IC_OPT_CAN_FD_EXTENDED==1
+        && !(CANFD_MTU == bytes_received && frame->len <= CANFD_MAX_DLEN)
+#endif   /* IC_OPT_CAN_FD_EXTENDED */
+    ) {
+        fprintf(stderr, "Hmm. Received an incomplete CAN frame. Skipping.\n");
+        return false;
+    }
+#if IC_OPT_DISABLE_CAN_DETAILS!=1
+    DPRINTLN("Received CAN frame with ID 0x%X.", frame->can_id);
+    DPRINT("Data: "); MEMDUMP(frame->data, frame->len);
+#endif   /* IC_OPT_DISABLE_CAN_DETAILS */
+
+    return true;
+}
+
+
+#if IC_OPT_CAN_BATCH_RECV==1
+static void
+process_can_frames(canbus_thread_ctx_t *ctx, ic_can_frame_t *frames, struct mmsghdr *msgs, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        if (!is_complete_frame(&frames[i], msgs[i].msg_len)) {
+            ++ctx->frames_incomplete;
+            continue;
+        }
+
+#if IC_OPT_LATENCY_TRACKING==1
+        can_rx_time_ns = rx_timestamp(&msgs[i].msg_hdr);
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+#if IC_OPT_CAN_INGEST_RING==1
+        ring_push(ctx, &frames[i]);
+#else   /* IC_OPT_CAN_INGEST_RING */
+        process_can_frame(ctx, &frames[i]);
+#endif   /* IC_OPT_CAN_INGEST_RING */
+    }
+}
+#endif   /* IC_OPT_CAN_BATCH_RECV */
+
+
+#if IC_OPT_LATENCY_TRACKING==1
+/* Pull the kernel's receive timestamp out of a received message. Falls back to 'now' if it's missing. */
+static inline uint64_t
+rx_timestamp(struct msghdr *header)
+{
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(header); NULL != cmsg; cmsg = CMSG_NXTHDR(header, cmsg)) {
+        if (SOL_SOCKET != cmsg->cmsg_level || SCM_TIMESTAMPNS != cmsg->cmsg_type) continue;
+
+        struct timespec stamp;
+        memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+
+        return (uint64_t)stamp.tv_sec * 1000000000ull + (uint64_t)stamp.tv_nsec;
+    }
+
+    return latency_now_ns();
+}
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+
+#if IC_OPT_CAN_INGEST_RING==1
+/* Reader side: queue one frame. Nothing is visible to the decoder until 'ring_publish'. */
 static inline void
-store_signal_value(dbc_signal_t *signal, uint8_t *frame_data, uint8_t frame_len)
+ring_push(canbus_thread_ctx_t *ctx, const ic_can_frame_t *frame)
 {
-    // MEMDUMP(frame_data, frame_len);
+    ingest_ring_t *ring = &ingest_rings[ctx->bus_index];
+
+    if (ring->pending_head - ring->cached_tail >= IC_OPT_CAN_RING_DEPTH) {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+        /* Still full: the decoder is behind. Dropping the newest frame keeps the reader moving. */
+        if (ring->pending_head - ring->cached_tail >= IC_OPT_CAN_RING_DEPTH) {
+            ++ctx->ring_overflows;
+            return;
+        }
+    }
+
+    ring->frames[ring->pending_head & (IC_OPT_CAN_RING_DEPTH - 1)] = *frame;
+#if IC_OPT_LATENCY_TRACKING==1
+    ring->rx_times_ns[ring->pending_head & (IC_OPT_CAN_RING_DEPTH - 1)] = can_rx_time_ns;
+#endif   /* IC_OPT_LATENCY_TRACKING */
+    ++ring->pending_head;
+
+    uint32_t occupancy = (uint32_t)(ring->pending_head - ring->cached_tail);
+    if (occupancy > ctx->ring_high_water) ctx->ring_high_water = occupancy;
+}
 
-    real_time_data_t *rtd = &(signal->real_time_data);
 
+/* Reader side: hand every pushed frame to the decoder at once, with a single wake-up. */
+static inline void
+ring_publish(canbus_thread_ctx_t *ctx)
+{
+    ingest_ring_t *ring = &ingest_rings[ctx->bus_index];
+
+    if (ring->pending_head == atomic_load_explicit(&ring->head, memory_order_relaxed)) return;
+
+    atomic_store_explicit(&ring->head, ring->pending_head, memory_order_release);
+    sem_post(&ring->pending);
+}
+
+
+/* Decoder side: drain everything published so far, then release the slots in one store. */
+static void *
+canbus_decoder(void *context)
+{
+    canbus_thread_ctx_t *ctx = (canbus_thread_ctx_t *)context;
+    ingest_ring_t *ring = &ingest_rings[ctx->bus_index];
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    while (true)
+    {
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        if (tail == ring->cached_head) {
+            if (ERR_CAN_LISTENING != ctx->thread_status && ERR_OK != ctx->thread_status) break;
+
+            /* Extra posts only cost a spurious pass; a post always follows the publish it announces. */
+            while (0 != sem_wait(&ring->pending) && EINTR == errno) ;
+            continue;
+        }
+
+        for (; tail != ring->cached_head; ++tail) {
+#if IC_OPT_LATENCY_TRACKING==1
+            can_rx_time_ns = ring->rx_times_ns[tail & (IC_OPT_CAN_RING_DEPTH - 1)];
+#endif   /* IC_OPT_LATENCY_TRACKING */
+            process_can_frame(ctx, &ring->frames[tail & (IC_OPT_CAN_RING_DEPTH - 1)]);
+        }
+
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+    return NULL;
+}
+#endif   /* IC_OPT_CAN_INGEST_RING */
+
+
+static inline uint64_t
+extract_raw_value(const dbc_signal_t *signal, const uint8_t *frame_data)
+{
     uint64_t value = 0, bit = 0;
     uint8_t bit_in_byte = 0;
 
     // TODO: This is probably really inefficient.
-    for (uint8_t i = 0, bit_index = signal->start_bit; i < (uint8_t)signal->signal_size; ++i, ++bit_index) {
+    for (uint16_t i = 0, bit_index = signal->start_bit; i < (uint16_t)signal->signal_size; ++i, ++bit_index) {
         if (signal->is_little_endian) {
             bit_in_byte = bit_index % 8;
             bit = (frame_data[bit_index / 8] >> bit_in_byte) & 0x01;
@@ -174,23 +619,69 @@ store_signal_value(dbc_signal_t *signal, uint8_t *frame_data, uint8_t frame_len)
         }
     }
 
-    /* Set the signal value. */
-    rtd->value = CLAMP(
+    return value;
+}
+
+
+static inline bool
+store_signal_value(dbc_signal_t *signal, uint8_t *frame_data, uint8_t frame_len)
+{
+    // MEMDUMP(frame_data, frame_len);
+
+    uint64_t value = extract_raw_value(signal, frame_data);
+
+    /* Publish the signal value. */
+    bool changed = signal_publish(signal, CLAMP(
         (signal->offset + ((double)value * signal->factor)),
         signal->minimum_value,
         signal->maximum_value
-    );
+    ));
 
     /* Welcome back (you'll be here awhile again). Uncomment for testing. */
     // printf(
     //     ">>>>> [%s:%u]:%016lX=%lu//%f\n",
-    //     signal->name, signal->is_little_endian, htobe64(*(uint64_t *)frame_data), value, rtd->value
+    //     signal->name, signal->is_little_endian, htobe64(*(uint64_t *)frame_data), value, rtd_read(&signal->real_time_data)
     // );
+
+    return changed;
+}
+
+
+/*
+ * Remember the last raw payload of every message, so byte-identical rebroadcasts skip decoding.
+ *  Returns true when the payload differs from the previous one (or is the first one seen).
+ */
+static inline bool
+payload_changed(const dbc_message_t *message, const uint8_t *data)
+{
+    size_t message_index = message - DBC.messages;
+
+    if (message->expected_length <= 8) {
+        /* Classic frames: a single 64-bit compare. Bytes past the message length are masked out. */
+        uint64_t payload = load_le64(data);
+        if (message->expected_length < 8) payload &= (1ull << (8 * message->expected_length)) - 1;
+
+        uint64_t last;
+        memcpy(&last, last_payloads[message_index], sizeof(last));
+        if (has_last_payload[message_index] && payload == last) return false;
+
+        memcpy(last_payloads[message_index], &payload, sizeof(payload));
+    } else {
+        /* FD frames: let libc's vectorized 'memcmp' do the work. */
+        size_t length = MIN(message->expected_length, sizeof(last_payloads[0]));
+        uint8_t *last = last_payloads[message_index];
+        if (has_last_payload[message_index] && 0 == memcmp(last, data, length)) return false;
+
+        memcpy(last, data, length);
+    }
+
+    has_last_payload[message_index] = true;
+    return true;
 }
 
 
 static void
-process_can_frame(struct canfd_frame *frame, ssize_t bytes_received)
+process_can_frame(canbus_thread_ctx_t *ctx, ic_can_frame_t *frame)
 {
     const dbc_message_t *message = NULL;
 
@@ -198,6 +689,8 @@ process_can_frame(struct canfd_frame *frame, ssize_t bytes_received)
 
 #if IC_OPT_ID_MAPPING==1
     if (ERR_OK != lookup_dbc_msg_by_id(frame->can_id, &message) || NULL == message) {
+#elif IC_OPT_ID_MAPPING==2
+    if (NULL == (message = lookup_sorted_dbc_msg_by_id(frame->can_id))) {
 #else   /* IC_OPT_ID_MAPPING */
     DBC_MSG_BY_ID(message, frame->can_id);
     if (NULL == message) {
@@ -205,40 +698,161 @@ process_can_frame(struct canfd_frame *frame, ssize_t bytes_received)
 #if IC_OPT_DISABLE_CAN_DETAILS!=1
         DPRINTLN(">>> WARNING: Unknown or invalid CAN ID: 0x%X. Skipped.", frame->can_id);
 #endif   /* IC_OPT_DISABLE_CAN_DETAILS */
+        ++ctx->frames_dropped;
+        return;
+    }
+
+    /* A known ID seen on a bus which doesn't carry its message is someone else's traffic. Ignore it. */
+    if (ctx->bus_index != message_bus[message - DBC.messages]) {
+        ++ctx->frames_dropped;
         return;
     }
 #if IC_OPT_DISABLE_CAN_DETAILS!=1
     DPRINTLN("INFO:  Received CAN message '%s'", message->name);
 #endif   /* IC_OPT_DISABLE_CAN_DETAILS */
 
-    /* Do not process incomplete messages. */
-    if (bytes_received < message->expected_length) {
+    /* Do not process incomplete messages. A classic-only build never completes a message over 8 bytes. */
+    if (frame->len < message->expected_length) {
         DPRINTLN("NOTICE:  Dropped frame '%s': shorter than expected message length.", message->name);
+        ++ctx->frames_dropped;
         return;
     }
 
     /* Clamp the frame's length to the expected message length by default. */
     frame->len = message->expected_length;
 
-    // TODO: Need to detect multiplexor signals that might be part of this message.
-    //    This should only update the rtd if the signal is associated with the current multiplexor channel.
-    //    Hence, all signals outside the current multiplexor channel must be ignored.
+    /* ECUs rebroadcast identical payloads constantly. Those can't change any signal, so skip them. */
+    if (!payload_changed(message, frame->data)) return;
+
+    ++ctx->frames_decoded;
+    bool changed = false;
+
+    if (NULL != message->decode) {
+        changed = message->decode(frame->data);
+    } else {
+        /* Decode the multiplexor first (if any): signals outside its active page must be ignored. */
+        const dbc_signal_t *multiplexor = NULL;
+        uint64_t mux = 0;
+
+        for (int i = 0; i < message->num_signals; ++i) {
+            if (Multiplexor != message->signals[i]->multiplex_type) continue;
+
+            multiplexor = message->signals[i];
+            mux = extract_raw_value(multiplexor, frame->data);
+            break;
+        }
+
+        for (int i = 0; i < message->num_signals; ++i) {
+            const dbc_signal_t *signal = message->signals[i];
+
+            if (
+                NULL != multiplexor
+                && (MultiplexedSignal == signal->multiplex_type || MultiplexorAndMultiplexedSignal == signal->multiplex_type)
+                && mux != signal->multiplexor
+            ) continue;
+
+            changed |= store_signal_value(message->signals[i], frame->data, frame->len);
+        }
+    }
+
+    /* A global flag prevents the drawing thread from needing to loop signals every pass. */
+    if (!changed) return;
+
+#if IC_OPT_IDLE_RENDER==1
+    /* Only the first update since the renderer last looked needs to wake it. */
+    if (!atomic_exchange_explicit(&CAN.has_update, true, memory_order_acq_rel)) {
+        uint64_t wake = 1;
+        if (sizeof(wake) != write(CAN.render_wake_fd, &wake, sizeof(wake))) DPRINTLN("WARNING:  Failed to wake the renderer.");
+    }
+#else   /* IC_OPT_IDLE_RENDER */
+    atomic_store_explicit(&CAN.has_update, true, memory_order_release);
+#endif   /* IC_OPT_IDLE_RENDER */
+}
+
+
+#if IC_OPT_CAN_ID_FILTER==1
+static inline bool
+message_is_referenced(const dbc_message_t *message)
+{
     for (int i = 0; i < message->num_signals; ++i) {
-        real_time_data_t *rtd = &(message->signals[i]->real_time_data);
+        if (message->signals[i]->num_widget_instances > 0) return true;
+
+        if (NULL != compile_time_ic_options.page_signal_name
+            && 0 == strcmp(message->signals[i]->name, compile_time_ic_options.page_signal_name)) return true;
+    }
+
+    return false;
+}
+
+
+static ic_err_t
+install_id_filters(int s_fd, int bus_index)
+{
+    struct can_filter *filters = NULL;
+    int num_filters = 0;
+
+    filters = malloc(sizeof(struct can_filter) * (DBC_MESSAGES_LEN + 1));
+    if (NULL == filters) return ERR_OUT_OF_RESOURCES;
+
+    /*
+     * Start with one exact filter per referenced message. The EFF flag is left out of the mask
+     *  because the DBC stores bare IDs, but remote frames are never of interest to a display.
+     */
+    for (int i = 0; i < DBC_MESSAGES_LEN; ++i) {
+        if (bus_index != message_bus[i] || !message_is_referenced(&DBC.messages[i])) continue;
+
+        filters[num_filters].can_id = DBC.messages[i].id & CAN_EFF_MASK;
+        filters[num_filters].can_mask = CAN_EFF_MASK | CAN_RTR_FLAG;
+        ++num_filters;
+    }
+
+    /*
+     * The kernel walks every filter for every frame, so keep the list short. Greedily merge the
+     *  pair of filters whose shared mask keeps the most ID bits until the list fits. Merged masks
+     *  can admit a few unreferenced IDs, which the userspace message lookup then drops as usual.
+     *  A DBC with no more messages than that always fits, so the merge isn't even compiled then.
+     */
+#if DBC_MESSAGES_LEN > IC_OPT_CAN_MAX_ID_FILTERS
+    while (num_filters > IC_OPT_CAN_MAX_ID_FILTERS) {
+        int best_a = 0, best_b = 1, best_bits = -1;
+
+        for (int a = 0; a < num_filters - 1; ++a) {
+            for (int b = a + 1; b < num_filters; ++b) {
+                canid_t mask = filters[a].can_mask & filters[b].can_mask
+                    & ~(filters[a].can_id ^ filters[b].can_id);
+                int bits = __builtin_popcount(mask & CAN_EFF_MASK);
+
+                if (bits > best_bits) {
+                    best_bits = bits;
+                    best_a = a;
+                    best_b = b;
+                }
+            }
+        }
 
-        /* ----- LOCK */ pthread_mutex_lock(&rtd->lock);
-        rtd->value = 0.0f;
-        store_signal_value(message->signals[i], frame->data, frame->len);
+        filters[best_a].can_mask &= filters[best_b].can_mask
+            & ~(filters[best_a].can_id ^ filters[best_b].can_id);
+        filters[best_a].can_id &= filters[best_a].can_mask;
+        filters[best_b] = filters[--num_filters];
+    }
+#endif   /* DBC_MESSAGES_LEN > IC_OPT_CAN_MAX_ID_FILTERS */
 
-        rtd->has_update = true;
-        /* ----- UNLOCK */ pthread_mutex_unlock(&rtd->lock);
+    DPRINTLN("Installing %d kernel CAN ID filter(s):", num_filters);
+    for (int i = 0; i < num_filters; ++i) {
+        DPRINTLN("\t>>> id 0x%08X / mask 0x%08X", filters[i].can_id, filters[i].can_mask);
+    }
 
-        /* A global bool prevents the drawing thread from needing to loop signals every pass. */
-        pthread_mutex_lock(&CAN.lock);
-        CAN.has_update = true;
-        pthread_mutex_unlock(&CAN.lock);
+    /* Zero filters is valid: it means nothing on the bus is displayed, so nothing is received. */
+    if (setsockopt(s_fd, SOL_CAN_RAW, CAN_RAW_FILTER, filters, sizeof(struct can_filter) * num_filters) < 0) {
+        perror("setsockopt");
+        free(filters);
+        return ERR_CAN_FILTER;
     }
+
+    free(filters);
+    return ERR_OK;
 }
+#endif   /* IC_OPT_CAN_ID_FILTER */
 
 
 #if IC_OPT_ID_MAPPING==1
@@ -296,3 +910,27 @@ lookup_dbc_msg_by_id(canid_t id, const dbc_message_t **out)
     return ERR_OK;
 }
 #endif   /* IC_OPT_ID_MAPPING */
+
+
+#if IC_OPT_ID_MAPPING==2
+static inline const dbc_message_t *
+lookup_sorted_dbc_msg_by_id(canid_t id)
+{
+    /* An empty DBC has nothing to search, not even a first ID to compare against. */
+    if (0 == DBC_MESSAGES_LEN) return NULL;
+
+    const uint32_t *base = DBC.sorted_message_ids;
+    uint32_t remaining = DBC_MESSAGES_LEN;
+
+    /* Branchless search for the last ID <= the wanted one. The loop count only depends on N. */
+    while (remaining > 1) {
+        uint32_t half = remaining / 2;
+        base = (base[half] <= id) ? &base[half] : base;
+        remaining -= half;
+    }
+
+    if (*base != id) return NULL;
+
+    return &DBC.messages[DBC.sorted_message_indices[base - DBC.sorted_message_ids]];
+}
+#endif   /* IC_OPT_ID_MAPPING */
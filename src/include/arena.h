@@ -0,0 +1,36 @@
+#ifndef IC_ARENA_H
+#define IC_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "flex_ic.h"
+
+
+/* New blocks are this big, unless one allocation needs more. A whole configuration usually fits the first. */
+#define IC_ARENA_BLOCK_SIZE     (64 * 1024)
+
+typedef struct ic_arena_block ic_arena_block_t;
+
+/*
+ * A bump allocator for memory which lives until everything in it goes at once. Allocations are
+ *  packed one after the other into large blocks, so what's allocated together stays together.
+ *  Zero-initialize it to start; not thread-safe.
+ */
+typedef
+struct {
+    ic_arena_block_t *blocks;   /* newest first; only the newest is allocated from */
+} ic_arena_t;
+
+/* Zeroed space for 'count' objects of 'size' bytes, aligned for any type. NULL when out of memory. */
+void *arena_alloc(ic_arena_t *arena, size_t count, size_t size);
+
+/* A copy of 'text' in the arena, or NULL. */
+char *arena_strdup(ic_arena_t *arena, const char *text);
+
+/* Free every block at once. Nothing allocated from the arena may be used afterwards, but the arena itself can be reused. */
+void arena_release(ic_arena_t *arena);
+
+
+
+#endif   /* IC_ARENA_H */
@@ -14,12 +14,26 @@
 typedef
 struct {
     const char *can_if_name;
+    int bus_index;   /* index into 'compile_time_ic_options.can.buses' */
     volatile ic_err_t thread_status;
     volatile bool is_listening;
     volatile bool should_close;
+
+    /* Ingestion statistics, written by the socket reader. */
+    volatile uint64_t frames_received;
+    volatile uint64_t frames_incomplete;
+    volatile uint64_t recv_calls;
+    volatile uint64_t ring_overflows;   /* frames lost to a full ingest ring (IC_OPT_CAN_INGEST_RING) */
+    volatile uint32_t ring_high_water;   /* deepest the ingest ring has been */
+
+    /* Decode statistics, written by the decoder (the reader itself without the ingest ring). */
+    volatile uint64_t frames_decoded;
+    volatile uint64_t frames_dropped;   /* unknown, shorter than their message, or belonging to another bus */
 } canbus_thread_ctx_t;
 
 
+ic_err_t canbus_init(void);
+
 void *canbus_listener(void *context);
 
 const char *canbus_status(ic_err_t status);
@@ -32,6 +32,51 @@ enum {
     ASSET
 } ic_background_type;
 
+/* One CAN interface and the DBC messages which are decoded from it. */
+typedef
+struct {
+    const char *interface_name;
+    const char **message_names;   /* NULL-terminated; NULL to take every message no other bus claims */
+} ic_can_bus_opts_t;
+
+
+/* One widget option, parsed by the configuration generator into every form it can take. */
+typedef
+struct {
+    const char *key;
+    const char *text;      /* as configured; JSON booleans read 'True' or 'False' */
+    double number;         /* only if 'is_number' */
+    Color color;           /* only if 'is_color': the text is an RRGGBBAA hex string */
+    struct {
+        double value;
+        bool is_percent;   /* of the widget's width (x) or height (y) */
+    } x, y;                /* only if 'is_coords': the text is 'X:Y', each optionally ending in '%' */
+    bool boolean;          /* the text reads 'true' or 'yes', in any case */
+    bool is_number;
+    bool is_color;
+    bool is_coords;
+} widget_option_t;
+
+/* One configured widget, fully resolved by the configuration generator. Lives in read-only data. */
+typedef
+struct {
+    const char *label;
+    const char *type;
+    const char *skin_name;
+    const uint16_t *signal_indices;     /* into 'DBC.signals', in channel order */
+    uint32_t num_signals;
+    int32_t visibility_signal_index;    /* shows the widget while non-zero; -1 for none */
+    vec2_t position;
+    vec2_t resolution;
+    float rotation;
+    uint32_t z_index;
+    uint8_t page;                       /* UINT8_MAX for every page */
+    bool visible;
+    bool draw_outline;
+    const widget_option_t *options;
+    uint32_t num_options;
+} widget_descriptor_t;
+
 
 /* Compile-time options structure. */
 typedef
@@ -41,6 +86,14 @@ struct {
         vec2_t dimensions;
         bool full_screen;
         const char *title;
+        uint32_t max_staleness_ms;   /* only used with IC_OPT_IDLE_RENDER */
+
+        /* Only used by the headless renderer. */
+        struct {
+            uint32_t frames;         /* frames to render before the loop returns; 0 to never return */
+            uint32_t dump_every;     /* write every Nth frame out as a PNG image (ExportImage); 0 to never */
+            const char *dump_path;   /* directory the images are written into */
+        } headless;
     } window;
 
     _func__render_splash splash_hook_func;
@@ -48,10 +101,13 @@ struct {
     const char **pages;
     int num_pages;
     int default_page_number;
+    const char *page_signal_name;   /* a signal whose value picks the page; NULL for none */
 
     struct {
-        const char *interface_name;
+        const ic_can_bus_opts_t *buses;
+        int num_buses;
         bool enable_fd;
+        uint32_t batch_timeout_us;   /* only used with IC_OPT_CAN_BATCH_RECV */
     } can;
 
     ic_background_type background_type;
@@ -82,6 +138,7 @@ struct {
 /* --- only the auto-generated files should have this set --- */
 #ifndef CONFIG_TYPES_ONLY
 #include <pthread.h>
+#include <stdatomic.h>
 
 #include "flex_ic_opts.h"
 #include "units.h"
@@ -93,6 +150,7 @@ struct {
 
 #include <float.h>
 #include <math.h>
+#include <string.h>
 
 #include "vehicle.h"
 
@@ -152,6 +210,8 @@ enum {
     ERR_CAN_SOCKET,
     ERR_CAN_IOCTL,
     ERR_CAN_BIND,
+    ERR_CAN_FILTER,
+    ERR_CAN_BUS_ASSIGNMENT,
     ERR_CAN_CLOSED,
 } ic_err_t;
 
@@ -159,9 +219,10 @@ enum {
 /* Track CAN-bus items globally where desired. */
 typedef
 struct {
-    volatile bool has_update;
-    pthread_mutex_t lock;
-    volatile void *can_thread_ctx;
+    atomic_bool has_update;   /* raised by the CAN thread, consumed by the render thread */
+    int render_wake_fd;   /* eventfd poked when 'has_update' is raised (IC_OPT_IDLE_RENDER), else -1 */
+    volatile void *can_thread_ctxs;   /* one listener context per configured bus */
+    int num_can_buses;
 } can_bus_meta_t;
 
 extern can_bus_meta_t CAN;
@@ -170,15 +231,33 @@ extern can_bus_meta_t CAN;
 typedef struct dbc_signal dbc_signal_t;
 typedef struct dbc_message dbc_message_t;
 
-/* Real-time data attachment for signals. */
+/*
+ * Real-time data attachment for signals.
+ *  This is a seqlock with exactly one writer (the CAN thread) and one consumer (the render thread),
+ *  so neither side ever blocks the other. The sequence is odd while a value is being published and
+ *  doubles as a generation counter: the render thread remembers the last sequence it consumed, and
+ *  a signal 'has an update' whenever the published sequence moves past it.
+ *  Always go through the 'rtd_*' helpers below rather than touching these fields directly.
+ */
 typedef
 struct {
-    volatile bool has_update;
+    atomic_uint sequence;
     volatile double value;
-    // int value_width;
-    pthread_mutex_t lock;
+    unsigned int seen_sequence;   /* owned by the render thread */
+#if IC_OPT_LATENCY_TRACKING==1
+    volatile uint64_t rx_time_ns;   /* kernel receive time of the frame which carried 'value' */
+#endif   /* IC_OPT_LATENCY_TRACKING */
 } real_time_data_t;
 
+/*
+ * Generated per-message decoder. Extracts and publishes every signal of the message from a frame payload.
+ *  Returns whether any signal's value actually changed.
+ */
+typedef
+bool (*_func__dbc_message_decode)(
+    const uint8_t *data
+);
+
 /* A structure holding a DBC message. */
 // TODO: Organize fields.
 struct dbc_message {
@@ -187,6 +266,7 @@ struct dbc_message {
     const char *name;
     dbc_signal_t **signals;
     uint32_t num_signals;
+    _func__dbc_message_decode decode;   /* NULL falls back to the generic bit-by-bit extraction */
 };
 
 /* Valid signal multiplex types. */
@@ -224,6 +304,13 @@ typedef
 struct {
     const dbc_message_t *messages;
     dbc_signal_t *signals;
+
+    /* All message IDs in ascending order, with the index of each ID's entry in 'messages'. */
+    const uint32_t *sorted_message_ids;
+    const uint16_t *sorted_message_indices;
+
+    /* The index of every entry in 'signals', in ascending 'strcmp' order of their names. */
+    const uint16_t *sorted_signal_indices;
 } dbc_t;
 
 /* References to external variables that should be defined only in vehicle.c. */
@@ -250,6 +337,125 @@ extern dbc_t DBC;
     }
 
 
+/*
+ * Unaligned 64-bit payload loads used by the generated message decoders.
+ *  No load starts past the last 8 bytes of a message, including the second one for a signal straddling
+ *  two words. A message is only decoded from a frame carrying at least its full length, so these never
+ *  read out of bounds.
+ */
+static inline uint64_t
+load_le64(const uint8_t *data)
+{
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif   /* __BYTE_ORDER__ */
+    return word;
+}
+
+static inline uint64_t
+load_be64(const uint8_t *data)
+{
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif   /* __BYTE_ORDER__ */
+    return word;
+}
+
+
+#if IC_OPT_LATENCY_TRACKING==1
+/* Receive timestamp of the frame the calling CAN thread is currently decoding. */
+extern _Thread_local uint64_t can_rx_time_ns;
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+/* CAN thread only: publish a new signal value. Unchanged values are not republished; returns whether it changed. */
+static inline bool
+rtd_publish(real_time_data_t *rtd, double value)
+{
+    /* The CAN thread is the only writer, so it can always read its own value directly. */
+    if (value == rtd->value) return false;
+
+    unsigned int sequence = atomic_load_explicit(&rtd->sequence, memory_order_relaxed);
+
+    atomic_store_explicit(&rtd->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    rtd->value = value;
+#if IC_OPT_LATENCY_TRACKING==1
+    rtd->rx_time_ns = can_rx_time_ns;
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+    atomic_store_explicit(&rtd->sequence, sequence + 2, memory_order_release);
+    return true;
+}
+
+/* Read a consistent signal value from any thread. Retries only while a publish is in flight. */
+static inline double
+rtd_read(const real_time_data_t *rtd)
+{
+    unsigned int before, after;
+    double value;
+
+    do {
+        before = atomic_load_explicit(&rtd->sequence, memory_order_acquire);
+        value = rtd->value;
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&rtd->sequence, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    return value;
+}
+
+#if IC_OPT_LATENCY_TRACKING==1
+/* Read the receive timestamp which belongs to the current value, from any thread. */
+static inline uint64_t
+rtd_read_rx_time(const real_time_data_t *rtd)
+{
+    unsigned int before, after;
+    uint64_t rx_time_ns;
+
+    do {
+        before = atomic_load_explicit(&rtd->sequence, memory_order_acquire);
+        rx_time_ns = rtd->rx_time_ns;
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&rtd->sequence, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    return rx_time_ns;
+}
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+/* Implemented with the widgets: flag every widget displaying 'signal' for an update on the next frame. */
+void mark_signal_widgets_dirty(const dbc_signal_t *signal);
+
+/* CAN thread only: publish a new signal value and schedule the widgets which display it. */
+static inline bool
+signal_publish(dbc_signal_t *signal, double value)
+{
+    if (!rtd_publish(&signal->real_time_data, value)) return false;
+
+    if (signal->num_widget_instances > 0) mark_signal_widgets_dirty(signal);
+    return true;
+}
+
+/* Render thread only: whether a value was published since the last 'rtd_consume'. */
+static inline bool
+rtd_has_update(const real_time_data_t *rtd)
+{
+    return (atomic_load_explicit(&rtd->sequence, memory_order_acquire) & ~1u) != rtd->seen_sequence;
+}
+
+/* Render thread only: mark every value published so far as seen. */
+static inline void
+rtd_consume(real_time_data_t *rtd)
+{
+    rtd->seen_sequence = atomic_load_explicit(&rtd->sequence, memory_order_acquire) & ~1u;
+}
+
+
 inline bool is_multiple(float numerator, float divisor)
 {
     if (divisor == 0) return false;
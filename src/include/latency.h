@@ -0,0 +1,22 @@
+#ifndef IC_LATENCY_H
+#define IC_LATENCY_H
+
+#include <stdint.h>
+
+#include "flex_ic.h"
+
+
+#if IC_OPT_LATENCY_TRACKING==1
+/* The current time on the clock the kernel stamps received CAN frames with. */
+uint64_t latency_now_ns(void);
+
+/* Render thread only: count 'samples' widgets which just displayed a value received 'latency_ns' ago. */
+void latency_record(uint64_t latency_ns, uint32_t samples);
+
+/* Render thread only: print the p50/p99/max frame-to-photon latency collected so far, then start over. */
+void latency_report(void);
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+
+
+#endif   /* IC_LATENCY_H */
@@ -0,0 +1,51 @@
+#ifndef IC_PROFILER_H
+#define IC_PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "flex_ic.h"
+#include "renderer.h"
+
+
+#if IC_OPT_PROFILER==1
+/* The environment variable which turns the profiler on at start-up: '1' for stats, 'overlay' for stats and overlay. */
+#define PROFILER_ENV_VAR    "FLEXIC_PROFILE"
+
+typedef
+enum {
+    PROFILE_UPDATE = 0,
+    PROFILE_DRAW,
+    PROFILE_NUM_PHASES
+} profile_phase_t;
+
+/*
+ * Allocate every sample buffer up front, read the start-up state from the environment, and let
+ *  SIGUSR1 toggle profiling at any time. Call once, after the widgets are loaded.
+ */
+ic_err_t profiler_init(uint32_t num_widgets);
+
+/* Whether the on-screen overlay is wanted. Only the renderer decides when to draw it. */
+bool profiler_overlay_enabled(void);
+void profiler_toggle_overlay(void);
+
+/* A monotonic time stamp to start a measurement at; 0 while profiling is off, so nothing is measured. */
+uint64_t profiler_begin(void);
+
+/* Render thread only: add the time since 'begin_ns' to the widget's 'phase' time for this frame. */
+void profiler_end_widget(uint32_t widget_index, profile_phase_t phase, uint64_t begin_ns);
+
+/*
+ * Render thread only: close the frame which started at 'begin_ns' and commit its widget times.
+ *  Once per period (or sooner, when the sample buffers fill) min/avg/p99 stats are computed, then
+ *  printed and kept for the overlay.
+ */
+void profiler_end_frame(uint64_t begin_ns);
+
+/* Render thread only: queue the last period's stats as draw commands, top-left under the FPS counter. */
+void profiler_draw_overlay(const renderer_t *renderer);
+#endif   /* IC_OPT_PROFILER */
+
+
+
+#endif   /* IC_PROFILER_H */
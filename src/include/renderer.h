@@ -12,6 +12,9 @@
 /* Function prototype declarations for renderer. This allows RAYLIB to be swapped out later as desired. */
 typedef struct renderer renderer_t;
 
+/* An offscreen drawing surface owned by the renderer. 0 is never a valid canvas. */
+typedef uint32_t ic_canvas_t;
+
 typedef
 ic_err_t (*_func__renderer_init)(
     const renderer_t *self
@@ -22,12 +25,90 @@ void (*_func__renderer_loop)(
     const renderer_t *self
 );
 
+typedef
+ic_canvas_t (*_func__renderer_canvas_create)(
+    const renderer_t *self,
+    int width,
+    int height
+);
+
+typedef
+void (*_func__renderer_canvas_begin)(
+    const renderer_t *self,
+    ic_canvas_t canvas
+);
+
+typedef
+void (*_func__renderer_canvas_end)(
+    const renderer_t *self
+);
+
+
+/*
+ * Widgets never draw directly. Each 'draw_*' call below appends a command to the renderer's draw
+ *  list, and the renderer submits the list when it chooses to, batching it however suits its
+ *  backend. Commands between 'canvas_begin' and 'canvas_end' draw into that canvas instead.
+ */
+typedef
+enum {
+    DRAW_RECT = 0,
+    DRAW_RECT_LINES,
+    DRAW_LINE,
+    DRAW_CIRCLE,
+    DRAW_ELLIPSE,
+    DRAW_RING,
+    DRAW_RING_LINES,
+    DRAW_CANVAS,
+    DRAW_TEXT,
+} draw_cmd_type_t;
+
+typedef
+struct {
+    draw_cmd_type_t type;
+    Color color;
+    Rectangle bounds;   /* everything the command may touch, for reordering */
+
+    union {
+        struct { Rectangle rect; Vector2 origin; float rotation; } rect;
+        struct { Rectangle rect; float thickness; } rect_lines;
+        struct { Vector2 start; Vector2 end; float thickness; } line;
+        struct { Vector2 center; float radius_h; float radius_v; } ellipse;   /* circles too */
+        struct {
+            Vector2 center;
+            float inner_radius;
+            float outer_radius;
+            float start_angle;
+            float end_angle;
+            int segments;
+        } ring;
+        struct { ic_canvas_t canvas; Rectangle source; Rectangle dest; Vector2 origin; float rotation; } canvas;
+        struct { uint32_t text_offset; Vector2 position; int size; } text;   /* text lives in 'strings' */
+    };
+} draw_cmd_t;
+
+typedef
+struct {
+    draw_cmd_t *cmds;
+    uint32_t count;
+    uint32_t capacity;
+
+    char *strings;   /* copies of every 'draw_text' string, so callers may reuse their buffers */
+    uint32_t strings_used;
+    uint32_t strings_capacity;
+} draw_list_t;
+
 
 /* Display properties (global). */
 struct renderer {
     _func__renderer_init    init;
     _func__renderer_loop    loop;
 
+    _func__renderer_canvas_create   canvas_create;
+    _func__renderer_canvas_begin    canvas_begin;
+    _func__renderer_canvas_end      canvas_end;
+
+    draw_list_t *draw_list;
+
     vec2_t resolution;
     uint8_t fps_limit;   /* set to 0 for no limit */
     const char *title;
@@ -37,12 +118,59 @@ struct renderer {
 extern const renderer_t *global_renderer;
 
 
-// TODO! If another Renderer besides Raylib is introduced (e.g. SDL2), we need
-//   to be able to abstract all GUI drawing functions out to an interface. This
-//   header file is where we can define that 'protocol' with a series of extra
-//   function pointers on the 'global_renderer' object. For example, instead of
-//   hard-coding 'DrawRectangle' from Raylib, we would attach a _func__draw_rect
-//   prototype to the global renderer and use that proxy implementation instead.
+/* Draw commands. Angles are in degrees, and canvas source rectangles are measured from the top-left. */
+void draw_rect(const renderer_t *renderer, Rectangle rect, Vector2 origin, float rotation, Color color);
+void draw_rect_lines(const renderer_t *renderer, Rectangle rect, float thickness, Color color);
+void draw_line(const renderer_t *renderer, Vector2 start, Vector2 end, float thickness, Color color);
+void draw_circle(const renderer_t *renderer, Vector2 center, float radius, Color color);
+void draw_ellipse(const renderer_t *renderer, Vector2 center, float radius_h, float radius_v, Color color);
+void draw_ring(
+    const renderer_t *renderer,
+    Vector2 center,
+    float inner_radius,
+    float outer_radius,
+    float start_angle,
+    float end_angle,
+    int segments,
+    Color color
+);
+void draw_ring_lines(
+    const renderer_t *renderer,
+    Vector2 center,
+    float inner_radius,
+    float outer_radius,
+    float start_angle,
+    float end_angle,
+    int segments,
+    Color color
+);
+void draw_canvas(
+    const renderer_t *renderer,
+    ic_canvas_t canvas,
+    Rectangle source,
+    Rectangle dest,
+    Vector2 origin,
+    float rotation,
+    Color tint
+);
+void draw_text(const renderer_t *renderer, const char *text, Vector2 position, int size, Color color);
+
+/* For backends: the text of a DRAW_TEXT command. */
+static inline const char *
+draw_cmd_text(const draw_list_t *list, const draw_cmd_t *cmd)
+{
+    return &list->strings[cmd->text.text_offset];
+}
+
+/*
+ * For backends: move commands next to earlier ones which share their texture, when nothing drawn
+ *  in between overlaps them, so consecutive commands can be submitted as one batch. The result
+ *  always looks exactly like drawing the list in its original order.
+ */
+void draw_list_batch(draw_list_t *list);
+
+/* For backends: forget every command in the list, keeping its memory. */
+void draw_list_clear(draw_list_t *list);
 
 
 
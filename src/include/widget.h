@@ -8,6 +8,7 @@
 #include "flex_ic.h"
 #include "renderer.h"
 
+#include <stddef.h>
 #include <stdio.h>
 
 
@@ -43,7 +44,7 @@ ic_err_t (*_func__widget_init)(
     const renderer_t *renderer
 );
 
-/* Widget state. */
+/* Widget state: what the frame loops read for every widget, each frame. Lives in 'widget_states'. */
 typedef
 struct {
     vec2_t position;
@@ -51,33 +52,34 @@ struct {
     double rotation;
     uint32_t z_index;   /* control widget rendering orders */
     volatile bool visible;   /* whether to draw the widget */
+    bool animating;   /* set by 'update' while the widget still moves without new signal data */
+    struct {
+        vec2_t position;
+        vec2_t resolution;
+    } bounds;   /* screen area 'draw' touches, if not its own rectangle; zero-sized to let the renderer derive it */
     void *internal;   /* state object custom to the widget instance and type */
 } widget_state_t;
 
-/* Named parameter (key-value) wrapper type for strings. */
-typedef
-struct {
-    char *key;
-    char *value;
-} key_value_t;
-
-/* Widget renderer main 'object'. */
+/* Widget renderer main 'object'. What a frame needs comes first; configuration, only read at load, last. */
 struct widget
 {
     _func__widget_update        update;
     _func__widget_draw          draw;
-    _func__widget_init          init;
+    _func__widget_draw          draw_static;   /* optional, set by 'init': content which never changes afterwards */
 
+    widget_state_t *state;   /* this widget's entry in 'widget_states' */
+    uint32_t index;   /* position in 'global_widgets' and 'widget_states', which are sorted by z-index */
+    uint32_t num_parent_signals;
+    dbc_signal_t **parent_signals;
+
+    _func__widget_init          init;
     const char *label;
     const char *type;
-    uint8_t page;
-    int argc;
-    key_value_t **argv;
-    char *skin_name;
-    dbc_signal_t **parent_signals;
-    uint32_t num_parent_signals;
+    const char *skin_name;
+    const widget_option_t *options;   /* already parsed by the configuration generator */
+    uint32_t num_options;
+    uint8_t page;   /* WIDGET_PAGE_ALL for widgets shown on every page */
     bool draw_outline;
-    widget_state_t state;
 };
 
 
@@ -91,17 +93,93 @@ ic_err_t (*func__widget_factory_create)(
 extern widget_t **global_widgets;
 extern uint32_t num_global_widgets;
 
+/*
+ * Every widget's state, packed in z order like 'global_widgets' (so by 'index'). Frame loops which
+ *  only need to look at a widget read it here, and touch its 'widget_t' only to call into it.
+ */
+extern widget_state_t *widget_states;
+
+#define WIDGET_PAGE_ALL     UINT8_MAX
+
+/* The widgets shown on one page by 'index', so in z order. Built once by 'load_widgets'. */
+typedef
+struct {
+    uint32_t *widgets;
+    uint32_t num_widgets;
+
+    uint32_t *visible_widgets;   /* the visible subset, also in z order; kept current by 'set_widget_visible' */
+    uint32_t num_visible_widgets;
+} widget_page_t;
+
+extern widget_page_t *widget_pages;
+extern uint32_t num_widget_pages;
 
-ic_err_t load_widgets(char *mutable_configuration);
+
+/* Create and link up every widget from the descriptors resolved at build time. */
+ic_err_t load_widgets(const widget_descriptor_t *descriptors, uint32_t num_descriptors);
+
+/*
+ * Zeroed memory which lives exactly as long as the widgets, for their skins' parameters and such.
+ *  It's bump-allocated next to the rest of the widgets' data and never freed on its own. NULL when out of memory.
+ */
+void *widget_alloc(size_t count, size_t size);
+
+/*
+ * Render thread only: collect the widgets whose signals changed since the last call, indexed like
+ *  'global_widgets', and clear them for the CAN threads. Returns how many there were.
+ */
+uint32_t take_dirty_widgets(bool *out_dirty);
+
+/*
+ * Render thread only: mark the signal values shown by the widgets of 'page' in 'widget_is_dirty' (by
+ *  widget 'index') as seen, once the frame showing them is presented. Also records their latency under IC_OPT_LATENCY_TRACKING.
+ */
+void consume_widget_signals(const widget_page_t *page, const bool *widget_is_dirty);
+
+/* Render thread only: the page being shown. Only its visible widgets should be updated or drawn. */
+const widget_page_t *active_widget_page(void);
+uint32_t active_widget_page_number(void);
+
+/*
+ * Render thread only: show another page. Its widgets are marked dirty, since they weren't updated
+ *  while it was hidden. Returns whether the page changed (false for the current or an unknown page).
+ */
+bool switch_widget_page(uint32_t page);
+
+/* Render thread only: switch to the page named by the page signal's value, if that value changed. */
+bool poll_page_signal(void);
+
+/* Render thread only: show or hide a widget on every page it's on. Returns whether that changed anything. */
+bool set_widget_visible(widget_t *widget, bool visible);
+
+/* Render thread only: a number which changes whenever any widget is shown or hidden. */
+uint32_t widget_visibility_epoch(void);
+
+/*
+ * Render thread only: show or hide the widgets whose visibility signal changed. Only widgets marked
+ *  in 'widget_is_dirty' are looked at, so call this right after 'take_dirty_widgets'.
+ */
+void apply_visibility_signals(bool *widget_is_dirty);
+
+#if IC_OPT_PARTIAL_REDRAW==1
+/*
+ * For renderers: the screen area a widget's 'draw' may touch, grown to whole pixels and clipped to the
+ *  window. Widgets which draw away from their own rectangle say so through 'state.bounds'.
+ */
+Rectangle widget_screen_bounds(const widget_state_t *state, const renderer_t *renderer);
+
+/* For renderers: fold overlapping dirty rectangles together in place. Returns how many are left. */
+int merge_dirty_rects(Rectangle *rects, int count);
+#endif   /* IC_OPT_PARTIAL_REDRAW */
 
 
 /* Various widget macros and functions to use for shorthanding or common operations. */
-#define MY_X self->state.position.x
-#define MY_Y self->state.position.y
-#define MY_WIDTH self->state.resolution.x
-#define MY_HEIGHT self->state.resolution.y
-#define MY_ANGLE self->state.rotation
-#define MY_Z_INDEX self->state.z_index
+#define MY_X self->state->position.x
+#define MY_Y self->state->position.y
+#define MY_WIDTH self->state->resolution.x
+#define MY_HEIGHT self->state->resolution.y
+#define MY_ANGLE self->state->rotation
+#define MY_Z_INDEX self->state->z_index
 
 extern const char *widget_default_skin_name;
 #define DEFAULT_SKIN widget_default_skin_name
@@ -129,12 +207,76 @@ void set_hooks_for_skin(
     _func__widget_parse_args parse_args_hook
 );
 
-char *get_option_by_key(widget_t *self, const char *name);
+/* A single option, or NULL. A linear scan: skins should fill their parameters with 'parse_widget_options'. */
+const widget_option_t *get_option_by_key(const widget_t *self, const char *name);
 
-#define OPTION_OR_DIE(option_name) \
-    name = option_name; \
-    option = get_option_by_key(self, option_name); \
-    if (NULL == option) goto param_error;
+/* The C type a skin parameter is filled as, and the form its option must have been parsed into. */
+typedef
+enum {
+    OPTION_FLOAT = 1,   /* float, from a number */
+    OPTION_INT,         /* int, from a number */
+    OPTION_BOOL,        /* bool, from any text: 'true' or 'yes' in any case, else false */
+    OPTION_TEXT,        /* const char *, from any text */
+    OPTION_COLOR,       /* Color, from an RRGGBBAA hex string */
+    OPTION_COORDS       /* vec2_t, from 'X:Y' with any '%' resolved against the widget's resolution */
+} widget_option_type_t;
+
+/* One entry of a skin's option schema: where and how an option lands in the skin's parameter struct. */
+typedef
+struct {
+    const char *key;
+    widget_option_type_t type;
+    size_t offset;   /* of the field in the parameter struct */
+    bool has_default;   /* optional; filled from 'fallback' when not configured */
+    union {
+        float number;   /* OPTION_FLOAT and OPTION_INT */
+        bool boolean;
+        const char *text;
+        Color color;
+        vec2_t coords;   /* in pixels */
+    } fallback;
+} widget_option_schema_t;
+
+/* The size of the C type each option type is filled as; see 'widget_option_type_t'. */
+#define WIDGET_OPTION_SIZE(option_type) \
+    (  (OPTION_FLOAT == (option_type)) ? sizeof(float) \
+     : (OPTION_INT == (option_type)) ? sizeof(int) \
+     : (OPTION_BOOL == (option_type)) ? sizeof(bool) \
+     : (OPTION_TEXT == (option_type)) ? sizeof(const char *) \
+     : (OPTION_COLOR == (option_type)) ? sizeof(Color) \
+     : (OPTION_COORDS == (option_type)) ? sizeof(vec2_t) : 0)
+
+/* The field's offset, failing the build when the field can't hold what its option type writes. */
+#define WIDGET_OPTION_OFFSET(option_type, params_type, field) \
+    (offsetof(params_type, field) + 0 * sizeof(struct { \
+        _Static_assert( \
+            sizeof(((params_type *)0)->field) == WIDGET_OPTION_SIZE(option_type), \
+            "Skin parameter '" #field "' does not match its option type." \
+        ); \
+        int unused; \
+    }))
+
+/* Schema entries, for a field of the skin's parameter struct 'params_type'. Defaults are designated initializers of 'fallback'. */
+#define WIDGET_OPTION(option_key, option_type, params_type, field) \
+    { .key = option_key, .type = option_type, .offset = WIDGET_OPTION_OFFSET(option_type, params_type, field) }
+#define WIDGET_OPTION_OR(option_key, option_type, params_type, field, ...) \
+    { \
+        .key = option_key, .type = option_type, .offset = WIDGET_OPTION_OFFSET(option_type, params_type, field), \
+        .has_default = true, .fallback = { __VA_ARGS__ } \
+    }
+
+/*
+ * Fill 'out_params' from the widget's options in one pass, by the 'schema' listed in ascending key
+ *  (strcmp) order. The configuration generator sorts each widget's options the same way, so both lists
+ *  are walked side by side rather than searched. Every missing or mistyped option is reported before
+ *  failing with ERR_ARGS; options the schema doesn't know are only warned about.
+ */
+ic_err_t parse_widget_options(
+    const widget_t *self,
+    const widget_option_schema_t *schema,
+    uint32_t schema_length,
+    void *out_params
+);
 
 
 
@@ -0,0 +1,96 @@
+#include "latency.h"
+
+#if IC_OPT_LATENCY_TRACKING==1
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+/*
+ * Log-linear latency histogram in microseconds: exact below 8us, then 8 buckets per power of two.
+ *  Any reported percentile is the upper bound of its bucket, so it overstates by at most 12.5%.
+ */
+#define LATENCY_SUB_BUCKET_BITS 3
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_OCTAVES 32   /* covers well over an hour; anything longer lands in the last bucket */
+#define LATENCY_BUCKETS (LATENCY_OCTAVES * LATENCY_SUB_BUCKETS)
+
+static uint64_t buckets[LATENCY_BUCKETS];
+static uint64_t num_samples;
+static uint64_t max_latency_ns;
+
+
+static inline int
+bucket_index(uint64_t latency_us)
+{
+    if (latency_us < LATENCY_SUB_BUCKETS) return (int)latency_us;
+
+    int msb = 63 - __builtin_clzll(latency_us);
+    int index = (msb - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS
+        + (int)((latency_us >> (msb - LATENCY_SUB_BUCKET_BITS)) & (LATENCY_SUB_BUCKETS - 1));
+
+    return MIN(index, LATENCY_BUCKETS - 1);
+}
+
+
+static inline uint64_t
+bucket_upper_bound_us(int index)
+{
+    if (index < LATENCY_SUB_BUCKETS) return (uint64_t)index;
+
+    int shift = index / LATENCY_SUB_BUCKETS - 1;
+    uint64_t lower = (uint64_t)(LATENCY_SUB_BUCKETS + index % LATENCY_SUB_BUCKETS) << shift;
+
+    return lower + (1ull << shift) - 1;
+}
+
+
+static uint64_t
+percentile_us(double percentile)
+{
+    uint64_t rank = (uint64_t)(percentile * (double)num_samples), seen = 0;
+
+    for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen > rank) return bucket_upper_bound_us(i);
+    }
+
+    return bucket_upper_bound_us(LATENCY_BUCKETS - 1);
+}
+
+
+uint64_t
+latency_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+
+void
+latency_record(uint64_t latency_ns, uint32_t samples)
+{
+    buckets[bucket_index(latency_ns / 1000)] += samples;
+    num_samples += samples;
+    if (latency_ns > max_latency_ns) max_latency_ns = latency_ns;
+}
+
+
+void
+latency_report(void)
+{
+    if (0 == num_samples) return;
+
+    printf(
+        ">>> Frame-to-photon latency over %" PRIu64 " widget updates: p50 <= %" PRIu64 " us, p99 <= %" PRIu64 " us, max %" PRIu64 " us\n",
+        num_samples, percentile_us(0.50), percentile_us(0.99), max_latency_ns / 1000
+    );
+
+    memset(buckets, 0, sizeof(buckets));
+    num_samples = 0;
+    max_latency_ns = 0;
+}
+#endif   /* IC_OPT_LATENCY_TRACKING */
@@ -6,6 +6,7 @@
 #include "renderer.h"
 #include "canbus.h"
 #include "widget.h"
+#include "profiler.h"
 
 /* Dynamically generated. Should only be included once, since it may contain value assignments. */
 #include "vehicle.h"
@@ -15,71 +16,85 @@
 #include <stdio.h>
 #include <signal.h>
 #include <string.h>
-
-
-/*
- * An external reference to the generated widgets-configuration.
- *  See the build process documentation for more details.
- */
-extern const char *WIDGETS_CONFIGURATION;
+#if IC_OPT_IDLE_RENDER==1
+#include <sys/eventfd.h>
+#endif   /* IC_OPT_IDLE_RENDER */
 
 
 /* Async objects which need to be accessible globally. */
-volatile canbus_thread_ctx_t can_bus_ctx;
+volatile canbus_thread_ctx_t can_bus_ctx[IC_OPT_CAN_NUM_BUSES];
 can_bus_meta_t CAN = {
     .has_update = false,
-    .lock = PTHREAD_MUTEX_INITIALIZER,
-    .can_thread_ctx = &can_bus_ctx
+    .render_wake_fd = -1,
+    .can_thread_ctxs = can_bus_ctx,
+    .num_can_buses = IC_OPT_CAN_NUM_BUSES
 };
 
 
 int
 main(int argc, char **argv)
 {
-    pthread_t can_bus_thread;
+    pthread_t can_bus_threads[IC_OPT_CAN_NUM_BUSES];
     ic_err_t status;
 
     /* Check auto-generated vehicle data and values. Make sure the defaults we need are there. */
     init_vehicle_dbc_data();
 
-    /* Populate the CAN bus thread context. */
-    can_bus_ctx = (canbus_thread_ctx_t)
-    {
-        .thread_status = ERR_OK,
-        .should_close = false,
-        .is_listening = false,
-        .can_if_name = compile_time_ic_options.can.interface_name
-    };
-
-    /* Load the widgets configuration. */
-    char *conf = strdup(WIDGETS_CONFIGURATION);
-    if (NULL == conf) {
-        fprintf(stderr, "ERROR:  Failed to load widget config (e:OUT_OF_RESOURCES). Aborting.\n");
-        exit(EXIT_FAILURE);
+    /* Populate the CAN bus thread contexts. Each bus gets its own listener, socket, and statistics. */
+    for (int b = 0; b < IC_OPT_CAN_NUM_BUSES; ++b) {
+        can_bus_ctx[b] = (canbus_thread_ctx_t)
+        {
+            .thread_status = ERR_OK,
+            .should_close = false,
+            .is_listening = false,
+            .can_if_name = compile_time_ic_options.can.buses[b].interface_name,
+            .bus_index = b
+        };
     }
 
-    /* Load all widgets associated with signals. */
-    if (ERR_OK != (status = load_widgets(conf))) {
+    /* Load all widgets associated with signals, from the descriptors generated with the configuration. */
+    if (ERR_OK != (status = load_widgets(WIDGET_DESCRIPTORS, NUM_WIDGET_DESCRIPTORS))) {
         fprintf(stderr, "ERROR:  Failed to load widgets (e:%u). Aborting.\n", status);
         exit(EXIT_FAILURE);
     }
 
-    free(conf); conf = NULL;   /* can let this go now... */
-
-    /* Spawn the CAN listener thread. Wait for the status to change to ERR_CAN_LISTENING or error. */
-    pthread_create(&can_bus_thread, NULL, canbus_listener, (void *)&can_bus_ctx);
+#if IC_OPT_PROFILER==1
+    /* Compiled in, but idle until switched on at run time. Profiling is never worth refusing to start over. */
+    if (ERR_OK != (status = profiler_init(num_global_widgets)))
+        fprintf(stderr, "WARNING:  Failed to set up the profiler (e:%u). Continuing without it.\n", status);
+#endif   /* IC_OPT_PROFILER */
 
-    while (ERR_OK == can_bus_ctx.thread_status) usleep(10000);
+#if IC_OPT_IDLE_RENDER==1
+    /* Lets the CAN threads wake an idle render loop. */
+    if ((CAN.render_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+        perror("eventfd");
+        exit(EXIT_FAILURE);
+    }
+#endif   /* IC_OPT_IDLE_RENDER */
 
-    if (ERR_CAN_LISTENING != can_bus_ctx.thread_status) {
-        fprintf(
-            stderr,
-            "ERROR: The CAN bus thread failed to enter the LISTENING state.\n>> Reason: %s\n\n",
-            canbus_status(can_bus_ctx.thread_status)
-        );
+    /* Assign DBC messages to buses before any listener starts receiving. */
+    if (ERR_OK != (status = canbus_init())) {
+        fprintf(stderr, "ERROR:  Failed to initialize CAN ingestion.\n>> Reason: %s\n\n", canbus_status(status));
         exit(EXIT_FAILURE);
     }
 
+    /* Spawn the CAN listener threads. Wait for each status to change to ERR_CAN_LISTENING or error. */
+    for (int b = 0; b < IC_OPT_CAN_NUM_BUSES; ++b)
+        pthread_create(&can_bus_threads[b], NULL, canbus_listener, (void *)&can_bus_ctx[b]);
+
+    for (int b = 0; b < IC_OPT_CAN_NUM_BUSES; ++b) {
+        while (ERR_OK == can_bus_ctx[b].thread_status) usleep(10000);
+
+        if (ERR_CAN_LISTENING != can_bus_ctx[b].thread_status) {
+            fprintf(
+                stderr,
+                "ERROR: The CAN bus thread for '%s' failed to enter the LISTENING state.\n>> Reason: %s\n\n",
+                can_bus_ctx[b].can_if_name, canbus_status(can_bus_ctx[b].thread_status)
+            );
+            exit(EXIT_FAILURE);
+        }
+    }
+
     /* Set up and enter the main rendering loop. */
     if (ERR_OK != global_renderer->init(global_renderer)) {
         fprintf(stderr, "ERROR:  Failed to initialize the IC renderer.\n");
@@ -93,10 +108,10 @@ main(int argc, char **argv)
 
     /* Always wait for the listener to close, if the code reaches these statements. */
     // fprintf(stdout, "Waiting on the CAN socket to close.\n    If this takes too long, just force-close the application...\n");
-    // can_bus_ctx.should_close = true;
-    // pthread_join(can_bus_thread, NULL);
-    /* Just kidding, destroy the thread immediately. We're exiting anyway. */
-    pthread_kill(can_bus_thread, SIGKILL);
+    // for (int b = 0; b < IC_OPT_CAN_NUM_BUSES; ++b) can_bus_ctx[b].should_close = true;
+    // for (int b = 0; b < IC_OPT_CAN_NUM_BUSES; ++b) pthread_join(can_bus_threads[b], NULL);
+    /* Just kidding, destroy the threads immediately. We're exiting anyway. */
+    for (int b = 0; b < IC_OPT_CAN_NUM_BUSES; ++b) pthread_kill(can_bus_threads[b], SIGKILL);
 
     /* All done. */
     return 0;
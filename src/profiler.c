@@ -0,0 +1,296 @@
+#include "profiler.h"
+
+#if IC_OPT_PROFILER==1
+#include "widget.h"
+
+#include <inttypes.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+#define PROFILER_PERIOD_NS ((uint64_t)IC_OPT_PROFILER_PERIOD_MS * 1000000ull)
+
+/* Samples kept per buffer: a period's worth of frames at twice the FPS limit, so they only fill early when that's off. */
+#define PROFILER_MIN_CAPACITY 64
+
+#define OVERLAY_TEXT_SIZE 10
+#define OVERLAY_LINE_HEIGHT 12
+#define OVERLAY_LINE_LENGTH 128
+
+typedef
+struct {
+    uint32_t count;
+    uint32_t min_ns;
+    uint32_t avg_ns;
+    uint32_t p99_ns;
+} profile_stats_t;
+
+/* Flipped from the SIGUSR1 handler, so it must be lock-free. Everything else belongs to the render thread. */
+static atomic_uint enabled;
+static bool ready;   /* nothing can switch profiling on until every buffer exists */
+static bool was_enabled;
+static bool overlay;
+
+static uint32_t num_profiled_widgets;
+static uint32_t capacity;
+
+/*
+ * Widget times are summed over the frame first (partial redraw may draw a widget once per dirty
+ *  area), then committed as one sample. A sum is never 0, so 0 means not called this frame.
+ */
+static uint64_t *frame_widget_ns;    /* [phase][widget] */
+static bool frame_touched;
+
+static uint32_t *widget_samples;     /* [phase][widget][capacity] */
+static uint32_t *num_widget_samples; /* [phase][widget] */
+static uint32_t *frame_samples;      /* [capacity] */
+static uint32_t num_frame_samples;
+static uint32_t *sort_scratch;       /* [capacity] */
+static uint64_t period_begin_ns;
+
+/* The last complete period, for the overlay. */
+static profile_stats_t *widget_stats;   /* [phase][widget] */
+static profile_stats_t frame_stats;
+static uint64_t stats_period_ns;
+static bool have_stats;
+
+static const char *phase_names[PROFILE_NUM_PHASES] = { "update", "draw" };
+
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+
+static void
+toggle_on_signal(int signal_number)
+{
+    (void)signal_number;
+    atomic_fetch_xor_explicit(&enabled, 1, memory_order_relaxed);
+}
+
+
+static int
+compare_samples(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+
+/* Nearest-rank p99, so it's always a time which was actually measured. */
+static profile_stats_t
+summarize(const uint32_t *samples, uint32_t count)
+{
+    profile_stats_t stats = { .count = count };
+    if (0 == count) return stats;
+
+    uint64_t total = 0;
+    stats.min_ns = UINT32_MAX;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        total += samples[i];
+        stats.min_ns = MIN(stats.min_ns, samples[i]);
+    }
+
+    memcpy(sort_scratch, samples, count * sizeof(uint32_t));
+    qsort(sort_scratch, count, sizeof(uint32_t), compare_samples);
+
+    stats.avg_ns = (uint32_t)(total / count);
+    stats.p99_ns = sort_scratch[(99 * (uint64_t)count + 99) / 100 - 1];
+
+    return stats;
+}
+
+
+static void
+start_period(uint64_t at_ns)
+{
+    memset(num_widget_samples, 0, PROFILE_NUM_PHASES * num_profiled_widgets * sizeof(uint32_t));
+    num_frame_samples = 0;
+    period_begin_ns = at_ns;
+}
+
+
+static void
+report_period(uint64_t period_ns)
+{
+    frame_stats = summarize(frame_samples, num_frame_samples);
+    stats_period_ns = period_ns;
+    have_stats = true;
+
+    for (uint32_t i = 0; i < PROFILE_NUM_PHASES * num_profiled_widgets; ++i)
+        widget_stats[i] = summarize(&widget_samples[(uint64_t)i * capacity], num_widget_samples[i]);
+
+    printf(
+        ">>> Profile over %" PRIu64 " ms, %u frames: frame min %.1f us, avg %.1f us, p99 %.1f us\n",
+        period_ns / 1000000, frame_stats.count,
+        frame_stats.min_ns / 1000.0, frame_stats.avg_ns / 1000.0, frame_stats.p99_ns / 1000.0
+    );
+
+    for (uint32_t w = 0; w < num_profiled_widgets; ++w) {
+        printf(">>>   [%2u] %-24s", w, global_widgets[w]->label);
+
+        for (int p = 0; p < PROFILE_NUM_PHASES; ++p) {
+            const profile_stats_t *stats = &widget_stats[p * num_profiled_widgets + w];
+
+            printf(
+                "  %s %4ux min %.1f avg %.1f p99 %.1f us",
+                phase_names[p], stats->count, stats->min_ns / 1000.0, stats->avg_ns / 1000.0, stats->p99_ns / 1000.0
+            );
+        }
+
+        printf("\n");
+    }
+}
+
+
+ic_err_t
+profiler_init(uint32_t num_widgets)
+{
+    num_profiled_widgets = num_widgets;
+    capacity = MAX(PROFILER_MIN_CAPACITY, 2 * (uint64_t)compile_time_ic_options.window.fps_limit * IC_OPT_PROFILER_PERIOD_MS / 1000);
+
+    frame_widget_ns = calloc(PROFILE_NUM_PHASES * num_widgets, sizeof(uint64_t));
+    widget_samples = calloc((uint64_t)PROFILE_NUM_PHASES * num_widgets * capacity, sizeof(uint32_t));
+    num_widget_samples = calloc(PROFILE_NUM_PHASES * num_widgets, sizeof(uint32_t));
+    widget_stats = calloc(PROFILE_NUM_PHASES * num_widgets, sizeof(profile_stats_t));
+    frame_samples = calloc(capacity, sizeof(uint32_t));
+    sort_scratch = calloc(capacity, sizeof(uint32_t));
+
+    if (NULL == frame_widget_ns || NULL == widget_samples || NULL == num_widget_samples
+        || NULL == widget_stats || NULL == frame_samples || NULL == sort_scratch)
+        return ERR_OUT_OF_RESOURCES;
+
+    struct sigaction toggle = { .sa_handler = toggle_on_signal, .sa_flags = SA_RESTART };
+    sigemptyset(&toggle.sa_mask);
+    if (0 != sigaction(SIGUSR1, &toggle, NULL)) return ERR_OUT_OF_RESOURCES;
+
+    ready = true;
+
+    const char *mode = getenv(PROFILER_ENV_VAR);
+
+    if (NULL != mode && 0 != strcmp(mode, "") && 0 != strcmp(mode, "0")) {
+        overlay = 0 == strcmp(mode, "overlay");
+        atomic_store_explicit(&enabled, 1, memory_order_relaxed);
+    }
+
+    return ERR_OK;
+}
+
+
+bool
+profiler_overlay_enabled(void)
+{
+    return overlay && 0 != atomic_load_explicit(&enabled, memory_order_relaxed);
+}
+
+
+void
+profiler_toggle_overlay(void)
+{
+    if (!ready) return;
+
+    overlay = !profiler_overlay_enabled();
+    if (overlay) atomic_store_explicit(&enabled, 1, memory_order_relaxed);   /* there's nothing to show otherwise */
+}
+
+
+uint64_t
+profiler_begin(void)
+{
+    return 0 != atomic_load_explicit(&enabled, memory_order_relaxed) ? now_ns() : 0;
+}
+
+
+void
+profiler_end_widget(uint32_t widget_index, profile_phase_t phase, uint64_t begin_ns)
+{
+    if (0 == begin_ns) return;
+
+    frame_widget_ns[phase * num_profiled_widgets + widget_index] += MAX(1, now_ns() - begin_ns);
+    frame_touched = true;
+}
+
+
+void
+profiler_end_frame(uint64_t begin_ns)
+{
+    bool is_enabled = 0 != atomic_load_explicit(&enabled, memory_order_relaxed);
+    uint64_t end_ns = now_ns();
+
+    if (is_enabled != was_enabled) {
+        printf(">>> Profiler %s.\n", is_enabled ? "on" : "off");
+        was_enabled = is_enabled;
+        have_stats = false;
+        start_period(end_ns);
+    }
+
+    /* A frame which straddles a toggle is dropped whole, rather than committed half measured. */
+    bool commit = is_enabled && 0 != begin_ns;
+
+    if (commit) frame_samples[num_frame_samples++] = (uint32_t)MIN(UINT32_MAX, end_ns - begin_ns);
+
+    if (frame_touched) {
+        for (uint32_t i = 0; i < PROFILE_NUM_PHASES * num_profiled_widgets; ++i) {
+            if (0 == frame_widget_ns[i]) continue;
+
+            if (commit) widget_samples[(uint64_t)i * capacity + num_widget_samples[i]++] = (uint32_t)MIN(UINT32_MAX, frame_widget_ns[i]);
+            frame_widget_ns[i] = 0;
+        }
+
+        frame_touched = false;
+    }
+
+    /* No widget gets more than one sample per frame, so the frame buffer is always the first to fill. */
+    if (is_enabled && (end_ns - period_begin_ns >= PROFILER_PERIOD_NS || capacity == num_frame_samples)) {
+        report_period(end_ns - period_begin_ns);
+        start_period(end_ns);
+    }
+}
+
+
+void
+profiler_draw_overlay(const renderer_t *renderer)
+{
+    if (!profiler_overlay_enabled() || !have_stats) return;
+
+    char line[OVERLAY_LINE_LENGTH];
+    float x = 10.0f, y = 40.0f;
+
+    draw_rect(
+        renderer,
+        (Rectangle){ x - 4, y - 4, 68 * OVERLAY_TEXT_SIZE * 3 / 5 + 8, (1 + num_profiled_widgets) * OVERLAY_LINE_HEIGHT + 8 },
+        (Vector2){ 0, 0 },
+        0.0f,
+        (Color){ 0, 0, 0, 192 }
+    );
+
+    snprintf(
+        line, sizeof(line), "frame   %4u in %" PRIu64 " ms  avg %7.1f  p99 %7.1f us",
+        frame_stats.count, stats_period_ns / 1000000, frame_stats.avg_ns / 1000.0, frame_stats.p99_ns / 1000.0
+    );
+    draw_text(renderer, line, (Vector2){ x, y }, OVERLAY_TEXT_SIZE, YELLOW);
+
+    for (uint32_t w = 0; w < num_profiled_widgets; ++w) {
+        const profile_stats_t *update = &widget_stats[PROFILE_UPDATE * num_profiled_widgets + w];
+        const profile_stats_t *draw = &widget_stats[PROFILE_DRAW * num_profiled_widgets + w];
+
+        y += OVERLAY_LINE_HEIGHT;
+        snprintf(
+            line, sizeof(line), "%-12.12s upd %6.1f/%6.1f  draw %6.1f/%6.1f us",
+            global_widgets[w]->label,
+            update->avg_ns / 1000.0, update->p99_ns / 1000.0, draw->avg_ns / 1000.0, draw->p99_ns / 1000.0
+        );
+        draw_text(renderer, line, (Vector2){ x, y }, OVERLAY_TEXT_SIZE, WHITE);
+    }
+}
+#endif   /* IC_OPT_PROFILER */
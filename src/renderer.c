@@ -0,0 +1,291 @@
+#include "renderer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+#define DRAW_LIST_INITIAL_CAPACITY 64
+
+/* Room for edge pixels (antialiasing, line caps) around each command's exact area. */
+#define BOUNDS_PADDING 2.0f
+
+
+static draw_cmd_t *
+push_cmd(const renderer_t *renderer, draw_cmd_type_t type, Color color)
+{
+    draw_list_t *list = renderer->draw_list;
+
+    if (list->count == list->capacity) {
+        uint32_t capacity = MAX(DRAW_LIST_INITIAL_CAPACITY, 2 * list->capacity);
+        draw_cmd_t *cmds = realloc(list->cmds, capacity * sizeof(draw_cmd_t));
+
+        if (NULL == cmds) {
+            DPRINTLN("WARNING:  Out of memory for draw commands. Dropping one.");
+            return NULL;
+        }
+
+        list->cmds = cmds;
+        list->capacity = capacity;
+    }
+
+    draw_cmd_t *cmd = &list->cmds[list->count++];
+    cmd->type = type;
+    cmd->color = color;
+
+    return cmd;
+}
+
+
+static Rectangle
+padded(float x, float y, float width, float height)
+{
+    return (Rectangle){
+        x - BOUNDS_PADDING,
+        y - BOUNDS_PADDING,
+        width + 2 * BOUNDS_PADDING,
+        height + 2 * BOUNDS_PADDING
+    };
+}
+
+
+/* A rectangle placed with its 'origin' on (rect.x, rect.y) and rotated about that point. */
+static Rectangle
+rotated_rect_bounds(Rectangle rect, Vector2 origin, float rotation)
+{
+    if (0.0f == rotation) return padded(rect.x - origin.x, rect.y - origin.y, rect.width, rect.height);
+
+    float radius = hypotf(MAX(origin.x, rect.width - origin.x), MAX(origin.y, rect.height - origin.y));
+    return padded(rect.x - radius, rect.y - radius, 2 * radius, 2 * radius);
+}
+
+
+void
+draw_rect(const renderer_t *renderer, Rectangle rect, Vector2 origin, float rotation, Color color)
+{
+    draw_cmd_t *cmd = push_cmd(renderer, DRAW_RECT, color);
+    if (NULL == cmd) return;
+
+    cmd->rect.rect = rect;
+    cmd->rect.origin = origin;
+    cmd->rect.rotation = rotation;
+    cmd->bounds = rotated_rect_bounds(rect, origin, rotation);
+}
+
+
+void
+draw_rect_lines(const renderer_t *renderer, Rectangle rect, float thickness, Color color)
+{
+    draw_cmd_t *cmd = push_cmd(renderer, DRAW_RECT_LINES, color);
+    if (NULL == cmd) return;
+
+    cmd->rect_lines.rect = rect;
+    cmd->rect_lines.thickness = thickness;
+    cmd->bounds = padded(rect.x, rect.y, rect.width, rect.height);
+}
+
+
+void
+draw_line(const renderer_t *renderer, Vector2 start, Vector2 end, float thickness, Color color)
+{
+    draw_cmd_t *cmd = push_cmd(renderer, DRAW_LINE, color);
+    if (NULL == cmd) return;
+
+    cmd->line.start = start;
+    cmd->line.end = end;
+    cmd->line.thickness = thickness;
+
+    float half = thickness / 2.0f;
+    cmd->bounds = padded(
+        MIN(start.x, end.x) - half,
+        MIN(start.y, end.y) - half,
+        fabsf(end.x - start.x) + thickness,
+        fabsf(end.y - start.y) + thickness
+    );
+}
+
+
+void
+draw_circle(const renderer_t *renderer, Vector2 center, float radius, Color color)
+{
+    draw_cmd_t *cmd = push_cmd(renderer, DRAW_CIRCLE, color);
+    if (NULL == cmd) return;
+
+    cmd->ellipse.center = center;
+    cmd->ellipse.radius_h = radius;
+    cmd->ellipse.radius_v = radius;
+    cmd->bounds = padded(center.x - radius, center.y - radius, 2 * radius, 2 * radius);
+}
+
+
+void
+draw_ellipse(const renderer_t *renderer, Vector2 center, float radius_h, float radius_v, Color color)
+{
+    draw_cmd_t *cmd = push_cmd(renderer, DRAW_ELLIPSE, color);
+    if (NULL == cmd) return;
+
+    cmd->ellipse.center = center;
+    cmd->ellipse.radius_h = radius_h;
+    cmd->ellipse.radius_v = radius_v;
+    cmd->bounds = padded(center.x - radius_h, center.y - radius_v, 2 * radius_h, 2 * radius_v);
+}
+
+
+static void
+push_ring(
+    const renderer_t *renderer,
+    draw_cmd_type_t type,
+    Vector2 center,
+    float inner_radius,
+    float outer_radius,
+    float start_angle,
+    float end_angle,
+    int segments,
+    Color color
+) {
+    draw_cmd_t *cmd = push_cmd(renderer, type, color);
+    if (NULL == cmd) return;
+
+    cmd->ring.center = center;
+    cmd->ring.inner_radius = inner_radius;
+    cmd->ring.outer_radius = outer_radius;
+    cmd->ring.start_angle = start_angle;
+    cmd->ring.end_angle = end_angle;
+    cmd->ring.segments = segments;
+    cmd->bounds = padded(center.x - outer_radius, center.y - outer_radius, 2 * outer_radius, 2 * outer_radius);
+}
+
+
+void
+draw_ring(
+    const renderer_t *renderer,
+    Vector2 center,
+    float inner_radius,
+    float outer_radius,
+    float start_angle,
+    float end_angle,
+    int segments,
+    Color color
+) {
+    push_ring(renderer, DRAW_RING, center, inner_radius, outer_radius, start_angle, end_angle, segments, color);
+}
+
+
+void
+draw_ring_lines(
+    const renderer_t *renderer,
+    Vector2 center,
+    float inner_radius,
+    float outer_radius,
+    float start_angle,
+    float end_angle,
+    int segments,
+    Color color
+) {
+    push_ring(renderer, DRAW_RING_LINES, center, inner_radius, outer_radius, start_angle, end_angle, segments, color);
+}
+
+
+void
+draw_canvas(
+    const renderer_t *renderer,
+    ic_canvas_t canvas,
+    Rectangle source,
+    Rectangle dest,
+    Vector2 origin,
+    float rotation,
+    Color tint
+) {
+    draw_cmd_t *cmd = push_cmd(renderer, DRAW_CANVAS, tint);
+    if (NULL == cmd) return;
+
+    cmd->canvas.canvas = canvas;
+    cmd->canvas.source = source;
+    cmd->canvas.dest = dest;
+    cmd->canvas.origin = origin;
+    cmd->canvas.rotation = rotation;
+    cmd->bounds = rotated_rect_bounds(dest, origin, rotation);
+}
+
+
+void
+draw_text(const renderer_t *renderer, const char *text, Vector2 position, int size, Color color)
+{
+    draw_list_t *list = renderer->draw_list;
+    uint32_t length = strlen(text);
+
+    if (list->strings_used + length + 1 > list->strings_capacity) {
+        uint32_t capacity = MAX(2 * list->strings_capacity, list->strings_used + length + 1);
+        char *strings = realloc(list->strings, capacity);
+
+        if (NULL == strings) {
+            DPRINTLN("WARNING:  Out of memory for draw command text. Dropping '%s'.", text);
+            return;
+        }
+
+        list->strings = strings;
+        list->strings_capacity = capacity;
+    }
+
+    draw_cmd_t *cmd = push_cmd(renderer, DRAW_TEXT, color);
+    if (NULL == cmd) return;
+
+    memcpy(&list->strings[list->strings_used], text, length + 1);
+
+    cmd->text.text_offset = list->strings_used;
+    cmd->text.position = position;
+    cmd->text.size = size;
+    cmd->bounds = padded(position.x, position.y, (float)length * size, (float)size);   /* glyphs are never wider than tall */
+
+    list->strings_used += length + 1;
+}
+
+
+/* Commands with the same key can be submitted together: shapes, one canvas, or text. */
+static uint32_t
+batch_key(const draw_cmd_t *cmd)
+{
+    switch (cmd->type) {
+        case DRAW_CANVAS: return cmd->canvas.canvas;
+        case DRAW_TEXT: return UINT32_MAX;
+        default: return 0;
+    }
+}
+
+
+static bool
+bounds_overlap(Rectangle a, Rectangle b)
+{
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+
+void
+draw_list_batch(draw_list_t *list)
+{
+    for (uint32_t i = 1; i < list->count; ++i) {
+        uint32_t key = batch_key(&list->cmds[i]);
+        if (batch_key(&list->cmds[i - 1]) == key) continue;
+
+        /* Slide back past commands it doesn't overlap, looking for the nearest one it can join. */
+        uint32_t j = i - 1;
+        while (j > 0 && !bounds_overlap(list->cmds[j].bounds, list->cmds[i].bounds)) {
+            if (batch_key(&list->cmds[j - 1]) == key) break;
+            --j;
+        }
+
+        if (0 == j || batch_key(&list->cmds[j - 1]) != key || bounds_overlap(list->cmds[j].bounds, list->cmds[i].bounds))
+            continue;
+
+        draw_cmd_t moved = list->cmds[i];
+        memmove(&list->cmds[j + 1], &list->cmds[j], (i - j) * sizeof(draw_cmd_t));
+        list->cmds[j] = moved;
+    }
+}
+
+
+void
+draw_list_clear(draw_list_t *list)
+{
+    list->count = 0;
+    list->strings_used = 0;
+}
@@ -0,0 +1,740 @@
+#include "renderer.h"
+#include "widget.h"
+#include "latency.h"
+#include "profiler.h"
+
+#include <raylib.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+
+/*
+ * Headless rendering methods. Frames are rasterized on the CPU into an in-memory RGBA image, and
+ *  only Raylib's image functions (which never touch a window or a GPU context) are used. Meant for
+ *  build boxes: benchmarking the frame loop and writing out frames to compare against known-good ones.
+ */
+static ic_err_t
+headless_render_init(const renderer_t *self);
+
+static void
+headless_render_loop(const renderer_t *self);
+
+static ic_canvas_t
+headless_canvas_create(const renderer_t *self, int width, int height);
+
+static void
+headless_canvas_begin(const renderer_t *self, ic_canvas_t canvas);
+
+static void
+headless_canvas_end(const renderer_t *self);
+
+
+/* Widget draw commands, waiting to be submitted. */
+static draw_list_t draw_list;
+
+/* The headless renderer container. Runs the same per-frame widget work as the desktop renderer. */
+static renderer_t renderer = {
+    .loop = headless_render_loop,
+    .init = headless_render_init,
+    .canvas_create = headless_canvas_create,
+    .canvas_begin = headless_canvas_begin,
+    .canvas_end = headless_canvas_end,
+    .draw_list = &draw_list,
+};
+
+const renderer_t *global_renderer = (const renderer_t *)&renderer;
+
+
+/* The background alone, composed once at init. Every frame (or repainted area) starts from a copy of it. */
+static Image background;
+
+/* The frame being composed. */
+static Image framebuffer;
+
+/* Canvas N is 'canvases[N - 1]'. Commands draw into 'target_canvas', or the framebuffer when 0. */
+static Image *canvases;
+static uint32_t num_canvases;
+static ic_canvas_t target_canvas;
+
+/* A pixel area, inclusive of both corners. */
+typedef
+struct {
+    int x0, y0;
+    int x1, y1;
+} pixel_box_t;
+
+/* Like Raylib's scissor mode: drawing into the framebuffer never touches pixels outside this box. */
+static pixel_box_t scissor = { 0, 0, INT_MAX, INT_MAX };
+
+
+/*
+ * Software rasterization. Every shape is filled by testing pixel centers, and blended over what's
+ *  already there the same way Raylib blends into render textures. There's no antialiasing.
+ */
+static inline void
+blend_pixel(Image *target, int x, int y, Color color)
+{
+    Color *px = &((Color *)target->data)[y * target->width + x];
+    *px = ColorAlphaBlend(*px, color, WHITE);
+}
+
+
+/* The pixels of 'target' which may be drawn to. */
+static inline pixel_box_t
+drawable_box(const Image *target)
+{
+    pixel_box_t box = { 0, 0, target->width - 1, target->height - 1 };
+    if (target != &framebuffer) return box;
+
+    return (pixel_box_t){ MAX(box.x0, scissor.x0), MAX(box.y0, scissor.y0), MIN(box.x1, scissor.x1), MIN(box.y1, scissor.y1) };
+}
+
+
+static void
+fill_triangle(Image *target, Vector2 a, Vector2 b, Vector2 c, Color color)
+{
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (0.0f == area) return;
+
+    float sign = area < 0.0f ? -1.0f : 1.0f;
+    pixel_box_t box = drawable_box(target);
+
+    int x0 = MAX(box.x0, (int)floorf(MIN(a.x, MIN(b.x, c.x))));
+    int y0 = MAX(box.y0, (int)floorf(MIN(a.y, MIN(b.y, c.y))));
+    int x1 = MIN(box.x1, (int)ceilf(MAX(a.x, MAX(b.x, c.x))));
+    int y1 = MIN(box.y1, (int)ceilf(MAX(a.y, MAX(b.y, c.y))));
+
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            Vector2 p = { x + 0.5f, y + 0.5f };
+
+            if (sign * ((b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x)) < 0.0f) continue;
+            if (sign * ((c.x - b.x) * (p.y - b.y) - (c.y - b.y) * (p.x - b.x)) < 0.0f) continue;
+            if (sign * ((a.x - c.x) * (p.y - c.y) - (a.y - c.y) * (p.x - c.x)) < 0.0f) continue;
+
+            blend_pixel(target, x, y, color);
+        }
+    }
+}
+
+
+static void
+fill_quad(Image *target, Vector2 a, Vector2 b, Vector2 c, Vector2 d, Color color)
+{
+    fill_triangle(target, a, b, c, color);
+    fill_triangle(target, a, c, d, color);
+}
+
+
+/* Where a point given relative to a placed rectangle's origin lands, as Raylib's '*Pro' functions place it. */
+static Vector2
+place(Vector2 pivot, float rotation, float x, float y)
+{
+    float s = sinf(rotation * DEG2RAD), c = cosf(rotation * DEG2RAD);
+    return (Vector2){ pivot.x + x * c - y * s, pivot.y + x * s + y * c };
+}
+
+
+static void
+fill_rect(Image *target, Rectangle rect, Vector2 origin, float rotation, Color color)
+{
+    Vector2 pivot = { rect.x, rect.y };
+
+    fill_quad(
+        target,
+        place(pivot, rotation, -origin.x, -origin.y),
+        place(pivot, rotation, rect.width - origin.x, -origin.y),
+        place(pivot, rotation, rect.width - origin.x, rect.height - origin.y),
+        place(pivot, rotation, -origin.x, rect.height - origin.y),
+        color
+    );
+}
+
+
+static void
+fill_line(Image *target, Vector2 start, Vector2 end, float thickness, Color color)
+{
+    float length = hypotf(end.x - start.x, end.y - start.y);
+    if (0.0f == length) return;
+
+    Vector2 n = { -(end.y - start.y) / length * thickness / 2.0f, (end.x - start.x) / length * thickness / 2.0f };
+
+    fill_quad(
+        target,
+        (Vector2){ start.x + n.x, start.y + n.y },
+        (Vector2){ end.x + n.x, end.y + n.y },
+        (Vector2){ end.x - n.x, end.y - n.y },
+        (Vector2){ start.x - n.x, start.y - n.y },
+        color
+    );
+}
+
+
+static void
+fill_ellipse(Image *target, Vector2 center, float radius_h, float radius_v, Color color)
+{
+    if (radius_h <= 0.0f || radius_v <= 0.0f) return;
+
+    pixel_box_t box = drawable_box(target);
+    int x0 = MAX(box.x0, (int)floorf(center.x - radius_h)), x1 = MIN(box.x1, (int)ceilf(center.x + radius_h));
+    int y0 = MAX(box.y0, (int)floorf(center.y - radius_v)), y1 = MIN(box.y1, (int)ceilf(center.y + radius_v));
+
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            float dx = (x + 0.5f - center.x) / radius_h, dy = (y + 0.5f - center.y) / radius_v;
+            if (dx * dx + dy * dy <= 1.0f) blend_pixel(target, x, y, color);
+        }
+    }
+}
+
+
+/* Rings are split into segments the same way Raylib splits them, so outlines line up with fills. */
+static Vector2
+ring_point(const draw_cmd_t *cmd, float radius, int segment)
+{
+    float angle = cmd->ring.start_angle + segment * ((cmd->ring.end_angle - cmd->ring.start_angle) / cmd->ring.segments);
+    return (Vector2){
+        cmd->ring.center.x + cosf(angle * DEG2RAD) * radius,
+        cmd->ring.center.y + sinf(angle * DEG2RAD) * radius
+    };
+}
+
+
+static void
+fill_ring(Image *target, const draw_cmd_t *cmd)
+{
+    for (int i = 0; i < cmd->ring.segments; ++i) {
+        fill_quad(
+            target,
+            ring_point(cmd, cmd->ring.outer_radius, i),
+            ring_point(cmd, cmd->ring.outer_radius, i + 1),
+            ring_point(cmd, cmd->ring.inner_radius, i + 1),
+            ring_point(cmd, cmd->ring.inner_radius, i),
+            cmd->color
+        );
+    }
+}
+
+
+static void
+stroke_ring(Image *target, const draw_cmd_t *cmd)
+{
+    for (int i = 0; i < cmd->ring.segments; ++i) {
+        fill_line(target, ring_point(cmd, cmd->ring.outer_radius, i), ring_point(cmd, cmd->ring.outer_radius, i + 1), 1.0f, cmd->color);
+        fill_line(target, ring_point(cmd, cmd->ring.inner_radius, i), ring_point(cmd, cmd->ring.inner_radius, i + 1), 1.0f, cmd->color);
+    }
+
+    if (fmodf(fabsf(cmd->ring.end_angle - cmd->ring.start_angle), 360.0f) != 0.0f) {
+        fill_line(target, ring_point(cmd, cmd->ring.inner_radius, 0), ring_point(cmd, cmd->ring.outer_radius, 0), 1.0f, cmd->color);
+        fill_line(
+            target,
+            ring_point(cmd, cmd->ring.inner_radius, cmd->ring.segments),
+            ring_point(cmd, cmd->ring.outer_radius, cmd->ring.segments),
+            1.0f,
+            cmd->color
+        );
+    }
+}
+
+
+/* Sample the canvas (nearest texel) for every target pixel inside the placed, rotated quad. */
+static void
+blit_canvas(Image *target, const draw_cmd_t *cmd)
+{
+    const Image *source = &canvases[cmd->canvas.canvas - 1];
+    Rectangle src = cmd->canvas.source, dest = cmd->canvas.dest;
+    Rectangle area = cmd->bounds;
+
+    if (0.0f == dest.width || 0.0f == dest.height) return;
+
+    float s = sinf(-cmd->canvas.rotation * DEG2RAD), c = cosf(-cmd->canvas.rotation * DEG2RAD);
+
+    pixel_box_t box = drawable_box(target);
+    int x0 = MAX(box.x0, (int)floorf(area.x)), x1 = MIN(box.x1, (int)ceilf(area.x + area.width));
+    int y0 = MAX(box.y0, (int)floorf(area.y)), y1 = MIN(box.y1, (int)ceilf(area.y + area.height));
+
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            float dx = x + 0.5f - dest.x, dy = y + 0.5f - dest.y;
+            float u = dx * c - dy * s + cmd->canvas.origin.x;
+            float v = dx * s + dy * c + cmd->canvas.origin.y;
+
+            if (u < 0.0f || v < 0.0f || u >= dest.width || v >= dest.height) continue;
+
+            int sx = (int)(src.x + u * (src.width / dest.width));
+            int sy = (int)(src.y + v * (src.height / dest.height));
+
+            if (sx < 0 || sy < 0 || sx >= source->width || sy >= source->height) continue;
+
+            Color texel = ((const Color *)source->data)[sy * source->width + sx];
+            blend_pixel(target, x, y, (Color){
+                texel.r * cmd->color.r / 255,
+                texel.g * cmd->color.g / 255,
+                texel.b * cmd->color.b / 255,
+                texel.a * cmd->color.a / 255
+            });
+        }
+    }
+}
+
+
+/* Rasterize every queued command into the current target. Order is all that matters on the CPU. */
+static void
+submit_draw_list(void)
+{
+    Image *target = 0 == target_canvas ? &framebuffer : &canvases[target_canvas - 1];
+
+    for (uint32_t i = 0; i < draw_list.count; ++i) {
+        const draw_cmd_t *cmd = &draw_list.cmds[i];
+
+        switch (cmd->type) {
+            case DRAW_RECT:
+                fill_rect(target, cmd->rect.rect, cmd->rect.origin, cmd->rect.rotation, cmd->color);
+                break;
+            case DRAW_RECT_LINES: {
+                Rectangle r = cmd->rect_lines.rect;
+                float t = cmd->rect_lines.thickness;
+
+                fill_rect(target, (Rectangle){ r.x, r.y, r.width, t }, (Vector2){ 0, 0 }, 0.0f, cmd->color);
+                fill_rect(target, (Rectangle){ r.x, r.y + r.height - t, r.width, t }, (Vector2){ 0, 0 }, 0.0f, cmd->color);
+                fill_rect(target, (Rectangle){ r.x, r.y + t, t, r.height - 2 * t }, (Vector2){ 0, 0 }, 0.0f, cmd->color);
+                fill_rect(target, (Rectangle){ r.x + r.width - t, r.y + t, t, r.height - 2 * t }, (Vector2){ 0, 0 }, 0.0f, cmd->color);
+                break;
+            }
+            case DRAW_LINE:
+                fill_line(target, cmd->line.start, cmd->line.end, cmd->line.thickness, cmd->color);
+                break;
+            case DRAW_CIRCLE:
+            case DRAW_ELLIPSE:
+                fill_ellipse(target, cmd->ellipse.center, cmd->ellipse.radius_h, cmd->ellipse.radius_v, cmd->color);
+                break;
+            case DRAW_RING:
+                fill_ring(target, cmd);
+                break;
+            case DRAW_RING_LINES:
+                stroke_ring(target, cmd);
+                break;
+            case DRAW_CANVAS:
+                blit_canvas(target, cmd);
+                break;
+            case DRAW_TEXT:
+                /* Raylib's font atlas is a GPU texture, so text is left out of headless frames. */
+                break;
+        }
+    }
+
+    draw_list_clear(&draw_list);
+}
+
+
+static ic_canvas_t
+headless_canvas_create(const renderer_t *self, int width, int height)
+{
+    Image *grown = realloc(canvases, (num_canvases + 1) * sizeof(Image));
+    if (NULL == grown) return 0;
+
+    canvases = grown;
+    canvases[num_canvases] = GenImageColor(width, height, BLANK);
+    if (NULL == canvases[num_canvases].data) return 0;
+
+    return ++num_canvases;
+}
+
+
+static void
+headless_canvas_begin(const renderer_t *self, ic_canvas_t canvas)
+{
+    submit_draw_list();   /* whatever was queued before belongs to the previous target */
+    target_canvas = canvas;
+}
+
+
+static void
+headless_canvas_end(const renderer_t *self)
+{
+    submit_draw_list();
+    target_canvas = 0;
+}
+
+
+/* Same corner order as Raylib's 'DrawRectangleGradientEx'. */
+static Color
+gradient_at(float u, float v, Color top_left, Color bottom_left, Color top_right, Color bottom_right)
+{
+    Color out;
+    const uint8_t *tl = &top_left.r, *bl = &bottom_left.r, *tr = &top_right.r, *br = &bottom_right.r;
+
+    for (int c = 0; c < 4; ++c) {
+        float left = tl[c] + (bl[c] - tl[c]) * v;
+        float right = tr[c] + (br[c] - tr[c]) * v;
+        (&out.r)[c] = (uint8_t)(left + (right - left) * u + 0.5f);
+    }
+
+    return out;
+}
+
+
+/* Compose the configured background (asset and/or gradient), exactly as the desktop renderer paints it. */
+static ic_err_t
+compose_background(Image *target)
+{
+    ImageClearBackground(target, ASSET == compile_time_ic_options.background_type
+        ? BLACK : compile_time_ic_options.background_color.static_color);
+
+    if (ASSET == compile_time_ic_options.background_type) {
+        Image asset = LoadImageFromMemory(
+            compile_time_ic_options.background_asset.file_type,
+            compile_time_ic_options.background_asset.image_data,
+            compile_time_ic_options.background_asset.image_size
+        );
+
+        if (NULL == asset.data) {
+            fprintf(stderr, "FATAL: Failed to load background image asset.\n");
+            return ERR_INVALID_CONFIGURATION;
+        }
+
+        int offset_x = compile_time_ic_options.background_asset.offset_x;
+        int offset_y = compile_time_ic_options.background_asset.offset_y;
+
+        ImageDraw(
+            target,
+            asset,
+            compile_time_ic_options.background_asset.fit_to_window
+                ? (Rectangle) { 0, 0, asset.width, asset.height }
+                : (Rectangle) { 0, 0, asset.width - offset_x, asset.height - offset_y },
+            compile_time_ic_options.background_asset.fit_to_window
+                ? (Rectangle) { 0, 0, target->width, target->height }
+                : (Rectangle) { offset_x, offset_y, target->width - offset_x, target->height - offset_y },
+            compile_time_ic_options.background_asset.tint
+        );
+
+        UnloadImage(asset);
+    }
+
+#if IC_OPT_BG_STATIC!=1
+    Color *pixels = (Color *)target->data;
+
+    for (int y = 0; y < target->height; ++y) {
+        for (int x = 0; x < target->width; ++x) {
+            Color *px = &pixels[y * target->width + x];
+
+            *px = ColorAlphaBlend(*px, gradient_at(
+                (float)x / MAX(1, target->width - 1),
+                (float)y / MAX(1, target->height - 1),
+                compile_time_ic_options.background_color.gradient_top_left,
+                compile_time_ic_options.background_color.gradient_bottom_left,
+                compile_time_ic_options.background_color.gradient_top_right,
+                compile_time_ic_options.background_color.gradient_bottom_right
+            ), WHITE);
+        }
+    }
+#endif   /* IC_OPT_BG_STATIC */
+
+    return ERR_OK;
+}
+
+
+static ic_err_t
+headless_render_init(const renderer_t *self)
+{
+    renderer.fps_limit = compile_time_ic_options.window.fps_limit;
+    renderer.title = compile_time_ic_options.window.title;
+    renderer.resolution = compile_time_ic_options.window.dimensions;   /* there is no screen to fill */
+
+    background = GenImageColor(renderer.resolution.x, renderer.resolution.y, BLACK);
+    framebuffer = GenImageColor(renderer.resolution.x, renderer.resolution.y, BLACK);
+
+    if (NULL == background.data || NULL == framebuffer.data) {
+        fprintf(stderr, "FATAL: Out of memory for the headless framebuffer.\n");
+        return ERR_OUT_OF_RESOURCES;
+    }
+
+    if (ERR_OK != compose_background(&background)) return ERR_INVALID_CONFIGURATION;
+
+    if (compile_time_ic_options.window.headless.dump_every > 0
+        && 0 != mkdir(compile_time_ic_options.window.headless.dump_path, 0755) && EEXIST != errno) {
+        fprintf(stderr, "FATAL: Cannot create frame dump directory '%s'.\n", compile_time_ic_options.window.headless.dump_path);
+        return ERR_INVALID_CONFIGURATION;
+    }
+
+    /* OK: Everything initialized with no issues. */
+    return ERR_OK;
+}
+
+
+static uint64_t
+thread_cpu_time_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+
+static void
+draw_widget(widget_t *widget, const renderer_t *renderer)
+{
+#if IC_OPT_PROFILER==1
+    uint64_t profile_begin_ns = profiler_begin();
+#endif   /* IC_OPT_PROFILER */
+
+    if (NULL != widget->draw_static) widget->draw_static(widget, renderer);
+    widget->draw(widget, renderer);
+
+#if IC_OPT_PROFILER==1
+    profiler_end_widget(widget->index, PROFILE_DRAW, profile_begin_ns);
+#endif   /* IC_OPT_PROFILER */
+}
+
+
+/* A red box around the boundary of the widget, which it asked for with 'draw_boundary_outline'. */
+static Rectangle
+outline_rect(const widget_state_t *state)
+{
+    return (Rectangle){
+        (float)state->position.x,
+        (float)state->position.y,
+        (float)state->resolution.x,
+        (float)state->resolution.y,
+    };
+}
+
+
+#if IC_OPT_PARTIAL_REDRAW==1
+/* Where a widget draws, including its outline: unlike on the desktop, outlines go into the frame itself. */
+static Rectangle
+repaint_bounds(uint32_t index, const renderer_t *renderer)
+{
+    Rectangle bounds = widget_screen_bounds(&widget_states[index], renderer);
+    if (!global_widgets[index]->draw_outline) return bounds;
+
+    Rectangle outline = outline_rect(&widget_states[index]);
+    float left = CLAMP(floorf(MIN(bounds.x, outline.x)), 0, renderer->resolution.x);
+    float top = CLAMP(floorf(MIN(bounds.y, outline.y)), 0, renderer->resolution.y);
+    float right = CLAMP(ceilf(MAX(bounds.x + bounds.width, outline.x + outline.width)), 0, renderer->resolution.x);
+    float bottom = CLAMP(ceilf(MAX(bounds.y + bounds.height, outline.y + outline.height)), 0, renderer->resolution.y);
+
+    return (Rectangle){ left, top, right - left, bottom - top };
+}
+
+
+/* Restore the background under one whole-pixel rectangle of the framebuffer. */
+static void
+restore_background(Rectangle rect)
+{
+    for (int y = (int)rect.y; y < (int)(rect.y + rect.height); ++y) {
+        size_t offset = (size_t)y * framebuffer.width + (size_t)rect.x;
+        memcpy(&((Color *)framebuffer.data)[offset], &((const Color *)background.data)[offset], (size_t)rect.width * sizeof(Color));
+    }
+}
+#endif   /* IC_OPT_PARTIAL_REDRAW */
+
+
+static void
+headless_render_loop(const renderer_t *self)
+{
+    if (0 == num_global_widgets || NULL == global_widgets) {
+        fprintf(stderr, "ERROR: Empty or NULL global_widgets.\n");
+        return;
+    }
+
+    /* Pre-init all widgets (for those that have a hook for it). */
+    for (int i = 0; i < num_global_widgets; ++i) {
+        if (NULL == global_widgets[i]->init) continue;
+
+        global_widgets[i]->init(global_widgets[i], self);
+    }
+
+    /* Which widgets have new signal data this frame. The CAN threads fill this in as they publish. */
+    bool *widget_is_dirty = calloc(num_global_widgets, sizeof(bool));
+    if (NULL == widget_is_dirty) {
+        fprintf(stderr, "ERROR: Out of memory for widget scheduling.\n");
+        return;
+    }
+
+#if IC_OPT_PARTIAL_REDRAW==1
+    /* The same dirty-region repaint as the desktop renderer, with the framebuffer as the persistent frame. */
+    Rectangle *last_bounds = calloc(num_global_widgets, sizeof(Rectangle));
+    Rectangle *dirty_rects = calloc(2 * num_global_widgets, sizeof(Rectangle));
+    const widget_page_t *repainted_page = NULL;   /* a different page always repaints everything... */
+    uint32_t repainted_epoch = 0;   /* ...and so does showing or hiding a widget */
+    bool full_repaint = true;
+    double repainted_fraction = 0.0;
+
+    if (NULL == last_bounds || NULL == dirty_rects) {
+        fprintf(stderr, "ERROR: Out of memory for dirty-region tracking.\n");
+        free(last_bounds);
+        free(dirty_rects);
+        free(widget_is_dirty);
+        return;
+    }
+#endif   /* IC_OPT_PARTIAL_REDRAW */
+
+    /* Frame cost is measured in render thread CPU time, so a loaded build box doesn't skew it. */
+    uint64_t frame_ns_total = 0, frame_ns_min = UINT64_MAX, frame_ns_max = 0;
+    uint32_t frame_count = 0;
+
+#if IC_OPT_LATENCY_TRACKING==1
+    uint64_t latency_reported_ns = latency_now_ns();
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+    /* Frames are never paced or skipped here: every one does the full per-frame work. */
+    while (0 == compile_time_ic_options.window.headless.frames || frame_count < compile_time_ic_options.window.headless.frames)
+    {
+        uint64_t begin_ns = thread_cpu_time_ns();
+
+#if IC_OPT_PROFILER==1
+        uint64_t profile_frame_begin_ns = profiler_begin();
+#endif   /* IC_OPT_PROFILER */
+
+        /* There are no keys to press here, so only the page signal switches pages. */
+        poll_page_signal();
+        const widget_page_t *page = active_widget_page();
+
+        /* Same ordering as the desktop loop: drop the wake-up flag, then collect dirty widgets. */
+        atomic_store_explicit(&CAN.has_update, false, memory_order_seq_cst);
+        take_dirty_widgets(widget_is_dirty);
+        apply_visibility_signals(widget_is_dirty);
+
+        for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+            uint32_t index = page->visible_widgets[i];
+            if (!widget_is_dirty[index] && !widget_states[index].animating) continue;
+
+            widget_t *widget = global_widgets[index];
+
+#if IC_OPT_PROFILER==1
+            uint64_t profile_begin_ns = profiler_begin();
+            widget->update(widget);
+            profiler_end_widget(widget->index, PROFILE_UPDATE, profile_begin_ns);
+#else   /* IC_OPT_PROFILER */
+            widget->update(widget);
+#endif   /* IC_OPT_PROFILER */
+        }
+
+#if IC_OPT_PARTIAL_REDRAW==1
+        /* Collect where widgets were and now are, for every widget with something new to show. */
+        int num_dirty = 0;
+
+        for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+            uint32_t index = page->visible_widgets[i];
+            Rectangle bounds = repaint_bounds(index, self);
+            bool moved = 0 != memcmp(&bounds, &last_bounds[index], sizeof(Rectangle));
+
+            if (moved || widget_is_dirty[index] || widget_states[index].animating) {
+                dirty_rects[num_dirty++] = last_bounds[index];
+                if (moved) dirty_rects[num_dirty++] = bounds;
+            }
+
+            last_bounds[index] = bounds;
+        }
+
+        if (page != repainted_page || widget_visibility_epoch() != repainted_epoch) {
+            repainted_page = page;
+            repainted_epoch = widget_visibility_epoch();
+            full_repaint = true;
+        }
+
+        if (full_repaint) {
+            dirty_rects[0] = (Rectangle){ 0, 0, self->resolution.x, self->resolution.y };
+            num_dirty = 1;
+            full_repaint = false;
+        }
+
+        num_dirty = merge_dirty_rects(dirty_rects, num_dirty);
+
+        for (int r = 0; r < num_dirty; ++r) {
+            Rectangle rect = dirty_rects[r];
+            if (rect.width <= 0 || rect.height <= 0) continue;
+
+            scissor = (pixel_box_t){ (int)rect.x, (int)rect.y, (int)(rect.x + rect.width) - 1, (int)(rect.y + rect.height) - 1 };
+            restore_background(rect);
+
+            for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+                uint32_t index = page->visible_widgets[i];
+                if (CheckCollisionRecs(last_bounds[index], rect)) draw_widget(global_widgets[index], self);
+            }
+
+            for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+                uint32_t index = page->visible_widgets[i];
+                if (!global_widgets[index]->draw_outline || !CheckCollisionRecs(last_bounds[index], rect)) continue;
+
+                draw_rect_lines(self, outline_rect(&widget_states[index]), 3.0f, RED);
+            }
+
+            /* Rasterized now, while the scissor still covers this rectangle. */
+            submit_draw_list();
+            repainted_fraction += (rect.width * rect.height) / (self->resolution.x * self->resolution.y);
+        }
+
+        scissor = (pixel_box_t){ 0, 0, INT_MAX, INT_MAX };
+#else   /* IC_OPT_PARTIAL_REDRAW */
+        memcpy(framebuffer.data, background.data, (size_t)framebuffer.width * framebuffer.height * sizeof(Color));
+
+        for (uint32_t i = 0; i < page->num_visible_widgets; ++i)
+            draw_widget(global_widgets[page->visible_widgets[i]], self);
+
+        for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+            if (!global_widgets[page->visible_widgets[i]]->draw_outline) continue;
+
+            draw_rect_lines(self, outline_rect(&widget_states[page->visible_widgets[i]]), 3.0f, RED);
+        }
+
+        submit_draw_list();
+#endif   /* IC_OPT_PARTIAL_REDRAW */
+
+        uint64_t frame_ns = thread_cpu_time_ns() - begin_ns;
+
+#if IC_OPT_PROFILER==1
+        /* No overlay: it's text, which this renderer doesn't rasterize. */
+        profiler_end_frame(profile_frame_begin_ns);
+#endif   /* IC_OPT_PROFILER */
+
+        frame_ns_total += frame_ns;
+        frame_ns_min = MIN(frame_ns_min, frame_ns);
+        frame_ns_max = MAX(frame_ns_max, frame_ns);
+        ++frame_count;
+
+        /* The composed frame counts as presented. */
+        consume_widget_signals(page, widget_is_dirty);
+
+        if (compile_time_ic_options.window.headless.dump_every > 0
+            && 0 == (frame_count - 1) % compile_time_ic_options.window.headless.dump_every) {
+            char path[PATH_MAX];
+            snprintf(path, sizeof(path), "%s/frame_%06u.png", compile_time_ic_options.window.headless.dump_path, frame_count - 1);
+
+            if (!ExportImage(framebuffer, path)) fprintf(stderr, "WARNING: Failed to write frame '%s'.\n", path);
+        }
+
+#if IC_OPT_LATENCY_TRACKING==1
+        /* Once a second by the clock, like the desktop loop: fps_limit may be 0 (uncapped). */
+        if (latency_now_ns() - latency_reported_ns >= 1000000000ull) {
+            latency_report();
+            latency_reported_ns = latency_now_ns();
+        }
+#endif   /* IC_OPT_LATENCY_TRACKING */
+    }
+
+    if (frame_count > 0) {
+        printf(
+            "Headless: %u frames at %dx%d. CPU time per frame: min %.1fus, avg %.1fus, max %.1fus.\n",
+            frame_count, self->resolution.x, self->resolution.y,
+            frame_ns_min / 1000.0, (double)frame_ns_total / frame_count / 1000.0, frame_ns_max / 1000.0
+        );
+#if IC_OPT_PARTIAL_REDRAW==1
+        printf("Headless: %.1f%% of the window repainted per frame on average.\n", 100.0 * repainted_fraction / frame_count);
+#endif   /* IC_OPT_PARTIAL_REDRAW */
+    }
+
+#if IC_OPT_PARTIAL_REDRAW==1
+    free(last_bounds);
+    free(dirty_rects);
+#endif   /* IC_OPT_PARTIAL_REDRAW */
+    free(widget_is_dirty);
+    UnloadImage(framebuffer);
+    UnloadImage(background);
+}
@@ -6,12 +6,17 @@
 
 #include "renderer.h"
 #include "widget.h"
+#include "latency.h"
+#include "profiler.h"
 
 #include <raylib.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
 #include <time.h>
+#if IC_OPT_IDLE_RENDER==1
+#include <poll.h>
+#endif   /* IC_OPT_IDLE_RENDER */
 
 
 /* Raylib-specific rendering methods. */
@@ -24,6 +29,18 @@ raylib_render_loading(const renderer_t *self);
 static void
 raylib_render_loop(const renderer_t *self);
 
+static ic_canvas_t
+raylib_canvas_create(const renderer_t *self, int width, int height);
+
+static void
+raylib_canvas_begin(const renderer_t *self, ic_canvas_t canvas);
+
+static void
+raylib_canvas_end(const renderer_t *self);
+
+
+/* Widget draw commands, waiting to be submitted. */
+static draw_list_t draw_list;
 
 /*
  * The primary desktop renderer container.
@@ -32,6 +49,10 @@ raylib_render_loop(const renderer_t *self);
 static renderer_t renderer = {
     .loop = raylib_render_loop,
     .init = raylib_render_init,
+    .canvas_create = raylib_canvas_create,
+    .canvas_begin = raylib_canvas_begin,
+    .canvas_end = raylib_canvas_end,
+    .draw_list = &draw_list,
 };
 
 const renderer_t *global_renderer = (const renderer_t *)&renderer;
@@ -40,6 +61,130 @@ const renderer_t *global_renderer = (const renderer_t *)&renderer;
 static Texture2D background_texture;
 static Image background_image;
 
+/* Canvas N is 'canvases[N - 1]'. */
+static RenderTexture2D *canvases;
+static uint32_t num_canvases;
+
+
+/*
+ * Draw every queued command to the current target. Raylib already merges consecutive draws which
+ *  use the same texture into one draw call, so batching the list first saves texture switches.
+ */
+static void
+submit_draw_list(void)
+{
+    draw_list_batch(&draw_list);
+
+    for (uint32_t i = 0; i < draw_list.count; ++i) {
+        const draw_cmd_t *cmd = &draw_list.cmds[i];
+
+        switch (cmd->type) {
+            case DRAW_RECT:
+                DrawRectanglePro(cmd->rect.rect, cmd->rect.origin, cmd->rect.rotation, cmd->color);
+                break;
+            case DRAW_RECT_LINES:
+                DrawRectangleLinesEx(cmd->rect_lines.rect, cmd->rect_lines.thickness, cmd->color);
+                break;
+            case DRAW_LINE:
+                DrawLineEx(cmd->line.start, cmd->line.end, cmd->line.thickness, cmd->color);
+                break;
+            case DRAW_CIRCLE:
+                DrawCircleV(cmd->ellipse.center, cmd->ellipse.radius_h, cmd->color);
+                break;
+            case DRAW_ELLIPSE:
+                DrawEllipse(cmd->ellipse.center.x, cmd->ellipse.center.y, cmd->ellipse.radius_h, cmd->ellipse.radius_v, cmd->color);
+                break;
+            case DRAW_RING:
+                DrawRing(
+                    cmd->ring.center, cmd->ring.inner_radius, cmd->ring.outer_radius,
+                    cmd->ring.start_angle, cmd->ring.end_angle, cmd->ring.segments, cmd->color
+                );
+                break;
+            case DRAW_RING_LINES:
+                DrawRingLines(
+                    cmd->ring.center, cmd->ring.inner_radius, cmd->ring.outer_radius,
+                    cmd->ring.start_angle, cmd->ring.end_angle, cmd->ring.segments, cmd->color
+                );
+                break;
+            case DRAW_CANVAS: {
+                /* Render textures are stored upside down. */
+                Texture2D texture = canvases[cmd->canvas.canvas - 1].texture;
+                Rectangle source = cmd->canvas.source;
+
+                source.y = texture.height - source.y - source.height;
+                source.height = -source.height;
+
+                DrawTexturePro(texture, source, cmd->canvas.dest, cmd->canvas.origin, cmd->canvas.rotation, cmd->color);
+                break;
+            }
+            case DRAW_TEXT:
+                DrawText(draw_cmd_text(&draw_list, cmd), cmd->text.position.x, cmd->text.position.y, cmd->text.size, cmd->color);
+                break;
+        }
+    }
+
+    draw_list_clear(&draw_list);
+}
+
+
+static ic_canvas_t
+raylib_canvas_create(const renderer_t *self, int width, int height)
+{
+    RenderTexture2D *grown = realloc(canvases, (num_canvases + 1) * sizeof(RenderTexture2D));
+    if (NULL == grown) return 0;
+
+    canvases = grown;
+    canvases[num_canvases] = LoadRenderTexture(width, height);
+
+    return ++num_canvases;
+}
+
+
+static void
+raylib_canvas_begin(const renderer_t *self, ic_canvas_t canvas)
+{
+    submit_draw_list();   /* whatever was queued before belongs to the previous target */
+    BeginTextureMode(canvases[canvas - 1]);
+}
+
+
+static void
+raylib_canvas_end(const renderer_t *self)
+{
+    submit_draw_list();
+    EndTextureMode();
+}
+
+
+#if IC_OPT_IDLE_RENDER==1
+/* Cap on each idle sleep, so window events (like closing) are still handled promptly. */
+#define IDLE_INPUT_POLL_MS 50
+
+/*
+ * Decide whether the next frame is worth drawing. When it isn't, sleep until the CAN thread
+ *  reports new data, the staleness timer runs out, or it's time to look at window events again.
+ */
+static bool
+should_render_frame(bool any_animating, double last_render_time)
+{
+    double stale_after = last_render_time + (compile_time_ic_options.window.max_staleness_ms / 1000.0);
+
+    if (any_animating || atomic_load_explicit(&CAN.has_update, memory_order_acquire) || GetTime() >= stale_after)
+        return true;
+
+    struct pollfd wake = { .fd = CAN.render_wake_fd, .events = POLLIN };
+    int timeout_ms = (int)ceil((stale_after - GetTime()) * 1000.0);
+
+    if (poll(&wake, 1, CLAMP(timeout_ms, 0, IDLE_INPUT_POLL_MS)) > 0) {
+        uint64_t wakes;
+        if (sizeof(wakes) != read(CAN.render_wake_fd, &wakes, sizeof(wakes))) DPRINTLN("WARNING:  Failed to drain renderer wake-ups.");
+    }
+
+    PollInputEvents();   /* normally done by 'EndDrawing', which a skipped frame never reaches */
+    return false;
+}
+#endif   /* IC_OPT_IDLE_RENDER */
+
 static ic_err_t
 raylib_render_init(const renderer_t *self)
 {
@@ -78,6 +223,163 @@ raylib_render_init(const renderer_t *self)
 }
 
 
+/* Paint the configured background (asset and/or gradient) over everything drawn so far. */
+static void
+draw_background(void)
+{
+    ClearBackground(ASSET == compile_time_ic_options.background_type
+        ? BLACK : compile_time_ic_options.background_color.static_color);
+
+    if (ASSET == compile_time_ic_options.background_type) {
+        DrawTexturePro(
+            background_texture,
+            compile_time_ic_options.background_asset.fit_to_window
+                ? (Rectangle) { 0, 0, background_image.width, background_image.height }
+                : (Rectangle) {
+                    0,
+                    0,
+                    background_image.width - compile_time_ic_options.background_asset.offset_x,
+                    background_image.height - compile_time_ic_options.background_asset.offset_y
+                },
+            compile_time_ic_options.background_asset.fit_to_window
+                ? (Rectangle) { 0, 0, GetScreenWidth(), GetScreenHeight() }
+                : (Rectangle) {
+                    compile_time_ic_options.background_asset.offset_x,
+                    compile_time_ic_options.background_asset.offset_y,
+                    GetScreenWidth() - compile_time_ic_options.background_asset.offset_x,
+                    GetScreenHeight() - compile_time_ic_options.background_asset.offset_y
+                },
+            (Vector2) { 0, 0 },
+            0.0f,
+            compile_time_ic_options.background_asset.tint
+        );
+    }
+
+#if IC_OPT_BG_STATIC!=1
+    DrawRectangleGradientEx(
+        (Rectangle){
+            .x = 0.0f,
+            .y = 0.0f,
+            .width = (float)renderer.resolution.x,
+            .height = (float)renderer.resolution.y
+        },
+        compile_time_ic_options.background_color.gradient_top_left,
+        compile_time_ic_options.background_color.gradient_bottom_left,
+        compile_time_ic_options.background_color.gradient_top_right,
+        compile_time_ic_options.background_color.gradient_bottom_right
+    );
+#endif   /* IC_OPT_BG_STATIC */
+}
+
+
+#if IC_OPT_PARTIAL_REDRAW==1 || IC_OPT_STATIC_LAYER==1
+/*
+ * Show a fully composed render texture exactly as composed. Blending while drawing into a texture
+ *  leaves its alpha below 1 under translucent pixels even though the texture is opaque, so blend
+ *  it premultiplied over black instead of alpha-blending it over whatever is underneath.
+ */
+static void
+blit_composed(RenderTexture2D composed, const renderer_t *renderer)
+{
+    ClearBackground(BLACK);
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTextureRec(
+        composed.texture,
+        (Rectangle){ 0, 0, (float)renderer->resolution.x, -(float)renderer->resolution.y },
+        (Vector2){ 0, 0 },
+        WHITE
+    );
+    EndBlendMode();
+}
+#endif   /* IC_OPT_PARTIAL_REDRAW || IC_OPT_STATIC_LAYER */
+
+
+#if IC_OPT_STATIC_LAYER==1
+/*
+ * Everything which never changes after init, composed once: the background, then the static faces
+ *  ('draw_static') of every visible widget on the page in z order. Frames start from a single blit of
+ *  it. Switching pages or showing/hiding a widget rebakes it.
+ */
+static RenderTexture2D static_layer;
+static const widget_page_t *static_layer_page;   /* the page the layer was last baked for */
+static uint32_t static_layer_epoch;   /* the visibility epoch it was baked at */
+
+static void
+bake_static_layer(const widget_page_t *page)
+{
+    BeginTextureMode(static_layer);
+    draw_background();
+
+    static_layer_page = page;
+    static_layer_epoch = widget_visibility_epoch();
+
+    for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+        widget_t *widget = global_widgets[page->visible_widgets[i]];
+        if (NULL == widget->draw_static) continue;
+
+        widget->draw_static(widget, global_renderer);
+    }
+
+    submit_draw_list();
+    EndTextureMode();
+}
+
+
+static bool
+static_layer_is_stale(const widget_page_t *page)
+{
+    return page != static_layer_page || widget_visibility_epoch() != static_layer_epoch;
+}
+#endif   /* IC_OPT_STATIC_LAYER */
+
+
+/* Everything underneath the widgets' changing content. */
+static void
+draw_base_layer(const renderer_t *renderer)
+{
+#if IC_OPT_STATIC_LAYER==1
+    blit_composed(static_layer, renderer);
+#else   /* IC_OPT_STATIC_LAYER */
+    draw_background();
+#endif   /* IC_OPT_STATIC_LAYER */
+}
+
+
+/* Only ever called for visible widgets. */
+static void
+draw_widget(widget_t *widget, const renderer_t *renderer)
+{
+#if IC_OPT_PROFILER==1
+    uint64_t profile_begin_ns = profiler_begin();
+#endif   /* IC_OPT_PROFILER */
+
+#if IC_OPT_STATIC_LAYER!=1
+    if (NULL != widget->draw_static) widget->draw_static(widget, renderer);
+#endif   /* IC_OPT_STATIC_LAYER */
+    widget->draw(widget, renderer);
+
+#if IC_OPT_PROFILER==1
+    profiler_end_widget(widget->index, PROFILE_DRAW, profile_begin_ns);
+#endif   /* IC_OPT_PROFILER */
+}
+
+
+/* Page Down/Up cycle through the pages, and the number keys pick one of the first nine. */
+static bool
+poll_page_keys(void)
+{
+    uint32_t page = active_widget_page_number();
+
+    if (IsKeyPressed(KEY_PAGE_DOWN)) return switch_widget_page((page + 1) % num_widget_pages);
+    if (IsKeyPressed(KEY_PAGE_UP)) return switch_widget_page((page + num_widget_pages - 1) % num_widget_pages);
+
+    for (uint32_t p = 0; p < MIN(9, num_widget_pages); ++p)
+        if (IsKeyPressed(KEY_ONE + p)) return switch_widget_page(p);
+
+    return false;
+}
+
+
 static void
 raylib_render_loop(const renderer_t *self)
 {
@@ -99,66 +401,203 @@ raylib_render_loop(const renderer_t *self)
         global_widgets[i]->init(global_widgets[i], self);
     }
 
+#if IC_OPT_STATIC_LAYER==1
+    /* Widget 'init' hooks prepare their static faces, so the layer can only be baked after them. */
+    static_layer = LoadRenderTexture(self->resolution.x, self->resolution.y);
+    bake_static_layer(active_widget_page());
+#endif   /* IC_OPT_STATIC_LAYER */
+
 #if IC_DEBUG==1 && IC_OPT_DISABLE_RENDER_TIME!=1
-    double *clock_samples = calloc(1, sizeof(double *) * compile_time_ic_options.window.fps_limit);
+    double *clock_samples = calloc(compile_time_ic_options.window.fps_limit, sizeof(double));
     int clock_sample_count = 0;
 #endif   /* IC_DEBUG */
 
+#if IC_OPT_LATENCY_TRACKING==1
+    uint64_t latency_reported_ns = latency_now_ns();
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+    /* Which widgets have new signal data this frame. The CAN threads fill this in as they publish. */
+    bool *widget_is_dirty = calloc(num_global_widgets, sizeof(bool));
+
+#if IC_OPT_IDLE_RENDER==1
+    bool any_animating = false;
+    double last_render_time = -INFINITY;   /* always draw the first frame */
+#endif   /* IC_OPT_IDLE_RENDER */
+
+#if IC_OPT_PARTIAL_REDRAW==1
+    /*
+     * The composed dashboard persists across frames in its own framebuffer. Each frame only the
+     *  areas of widgets which changed are repainted into it (background first, then every widget
+     *  overlapping the area in z order), and the whole framebuffer is then shown with one blit.
+     */
+    RenderTexture2D framebuffer = LoadRenderTexture(self->resolution.x, self->resolution.y);
+    Rectangle *last_bounds = calloc(num_global_widgets, sizeof(Rectangle));
+    Rectangle *dirty_rects = calloc(2 * num_global_widgets, sizeof(Rectangle));
+    const widget_page_t *repainted_page = NULL;   /* a different page always repaints everything... */
+    uint32_t repainted_epoch = 0;   /* ...and so does showing or hiding a widget */
+    bool full_repaint = true;
+
+    if (NULL == last_bounds || NULL == dirty_rects) {
+        fprintf(stderr, "ERROR: Out of memory for dirty-region tracking.\n");
+        goto teardown;
+    }
+
+#if IC_DEBUG==1 && IC_OPT_DISABLE_RENDER_TIME!=1
+    double repainted_fraction = 0.0;
+#endif   /* IC_DEBUG */
+#endif   /* IC_OPT_PARTIAL_REDRAW */
+
+    /* Only checked now, so everything the teardown below releases has been set up either way. */
+    if (NULL == widget_is_dirty) {
+        fprintf(stderr, "ERROR: Out of memory for widget scheduling.\n");
+        goto teardown;
+    }
+
     while (!WindowShouldClose())
     {
+        /* Switching pages is all this costs: each page's widget list was built at load time. */
+        bool page_switched = poll_page_keys();
+        page_switched |= poll_page_signal();
+
+#if IC_OPT_PROFILER==1
+        if (IsKeyPressed(KEY_F3)) profiler_toggle_overlay();
+#endif   /* IC_OPT_PROFILER */
+
+#if IC_OPT_IDLE_RENDER==1
+        if (!should_render_frame(any_animating || page_switched, last_render_time)) continue;
+
+        last_render_time = GetTime();
+        any_animating = false;
+#endif   /* IC_OPT_IDLE_RENDER */
+
+        /* Widgets on other pages, and hidden widgets, are neither updated nor drawn. */
+        const widget_page_t *page = active_widget_page();
+
 #if IC_DEBUG==1 && IC_OPT_DISABLE_RENDER_TIME!=1
         clock_t begin = clock();
 #endif   /* IC_DEBUG */
 
-        /* Widget updates. */
-        for (int i = 0; i < num_global_widgets; ++i)
-            global_widgets[i]->update(global_widgets[i]);
+#if IC_OPT_PROFILER==1
+        uint64_t profile_frame_begin_ns = profiler_begin();
+#endif   /* IC_OPT_PROFILER */
+
+        /*
+         * Drop the wake-up flag before collecting dirty widgets: anything published after this point
+         *  either makes this frame's set or raises the flag again for the next frame.
+         */
+        atomic_store_explicit(&CAN.has_update, false, memory_order_seq_cst);
+        take_dirty_widgets(widget_is_dirty);
+        apply_visibility_signals(widget_is_dirty);
+
+        /* Widget updates. Only widgets with new signal data, or animations in flight, have any work. */
+        for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+            uint32_t index = page->visible_widgets[i];
+            if (!widget_is_dirty[index] && !widget_states[index].animating) continue;
+
+            widget_t *widget = global_widgets[index];
+
+#if IC_OPT_PROFILER==1
+            uint64_t profile_begin_ns = profiler_begin();
+            widget->update(widget);
+            profiler_end_widget(widget->index, PROFILE_UPDATE, profile_begin_ns);
+#else   /* IC_OPT_PROFILER */
+            widget->update(widget);
+#endif   /* IC_OPT_PROFILER */
+#if IC_OPT_IDLE_RENDER==1
+            any_animating |= widget_states[index].animating;
+#endif   /* IC_OPT_IDLE_RENDER */
+        }
 
-        BeginDrawing();
+#if IC_OPT_STATIC_LAYER==1
+        if (static_layer_is_stale(page)) {
+            bake_static_layer(page);
+#if IC_OPT_PARTIAL_REDRAW==1
+            full_repaint = true;
+#endif   /* IC_OPT_PARTIAL_REDRAW */
+        }
+#endif   /* IC_OPT_STATIC_LAYER */
 
-        ClearBackground(ASSET == compile_time_ic_options.background_type
-            ? BLACK : compile_time_ic_options.background_color.static_color);
+#if IC_OPT_PARTIAL_REDRAW==1
+        /* Collect where widgets were and now are, for every widget with something new to show. */
+        int num_dirty = 0;
 
-        if (ASSET == compile_time_ic_options.background_type) {
-            DrawTexturePro(
-                background_texture,
-                compile_time_ic_options.background_asset.fit_to_window
-                    ? (Rectangle) { 0, 0, background_image.width, background_image.height }
-                    : (Rectangle) {
-                        0,
-                        0,
-                        background_image.width - compile_time_ic_options.background_asset.offset_x,
-                        background_image.height - compile_time_ic_options.background_asset.offset_y
-                    },
-                compile_time_ic_options.background_asset.fit_to_window
-                    ? (Rectangle) { 0, 0, GetScreenWidth(), GetScreenHeight() }
-                    : (Rectangle) {
-                        compile_time_ic_options.background_asset.offset_x,
-                        compile_time_ic_options.background_asset.offset_y,
-                        GetScreenWidth() - compile_time_ic_options.background_asset.offset_x,
-                        GetScreenHeight() - compile_time_ic_options.background_asset.offset_y
-                    },
-                (Vector2) { 0, 0 },
-                0.0f,
-                compile_time_ic_options.background_asset.tint
-            );
+        for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+            uint32_t index = page->visible_widgets[i];
+            Rectangle bounds = widget_screen_bounds(&widget_states[index], self);
+            bool moved = 0 != memcmp(&bounds, &last_bounds[index], sizeof(Rectangle));
+
+            if (moved || widget_is_dirty[index] || widget_states[index].animating) {
+                dirty_rects[num_dirty++] = last_bounds[index];
+                if (moved) dirty_rects[num_dirty++] = bounds;
+            }
+
+            last_bounds[index] = bounds;
+        }
+
+        if (page != repainted_page || widget_visibility_epoch() != repainted_epoch) {
+            repainted_page = page;
+            repainted_epoch = widget_visibility_epoch();
+            full_repaint = true;
+        }
+
+        if (full_repaint) {
+            dirty_rects[0] = (Rectangle){ 0, 0, self->resolution.x, self->resolution.y };
+            num_dirty = 1;
+            full_repaint = false;
         }
 
+        num_dirty = merge_dirty_rects(dirty_rects, num_dirty);
+
+        BeginTextureMode(framebuffer);
+
+        for (int r = 0; r < num_dirty; ++r) {
+            if (dirty_rects[r].width <= 0 || dirty_rects[r].height <= 0) continue;
+
+            BeginScissorMode(dirty_rects[r].x, dirty_rects[r].y, dirty_rects[r].width, dirty_rects[r].height);
+            draw_base_layer(self);
+
+            for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+                uint32_t index = page->visible_widgets[i];
+                if (!CheckCollisionRecs(last_bounds[index], dirty_rects[r])) continue;
+
+                draw_widget(global_widgets[index], self);
+            }
+
+            submit_draw_list();
+            EndScissorMode();
+
+#if IC_DEBUG==1 && IC_OPT_DISABLE_RENDER_TIME!=1
+            repainted_fraction += (dirty_rects[r].width * dirty_rects[r].height) / (self->resolution.x * self->resolution.y);
+#endif   /* IC_DEBUG */
+        }
+
+        EndTextureMode();
+
+        BeginDrawing();
+        blit_composed(framebuffer, self);
+#else   /* IC_OPT_PARTIAL_REDRAW */
+        BeginDrawing();
+
+        draw_base_layer(self);
+#endif   /* IC_OPT_PARTIAL_REDRAW */
+
         // TODO: Warn many times that rendering these with "draw_boundary_outline" is SLOW!!!
         if (any_outlines) {
             BeginTextureMode(outline_texture);
             ClearBackground((Color){0,0,0,0});
 
-            for (int i = 0; i < num_global_widgets; ++i) {
-                if (!global_widgets[i]->draw_outline) continue;
+            for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+                if (!global_widgets[page->visible_widgets[i]]->draw_outline) continue;
+
+                const widget_state_t *state = &widget_states[page->visible_widgets[i]];
 
                 /* Add a red box around the boundary of the widget to outline it. */
                 DrawRectangleLinesEx(
                     (Rectangle){
-                        (float)global_widgets[i]->state.position.x,
-                        (float)global_widgets[i]->state.position.y,
-                        (float)global_widgets[i]->state.resolution.x,
-                        (float)global_widgets[i]->state.resolution.y,
+                        (float)state->position.x,
+                        (float)state->position.y,
+                        (float)state->resolution.x,
+                        (float)state->resolution.y,
                     },
                     3.0f,
                     RED
@@ -168,40 +607,13 @@ raylib_render_loop(const renderer_t *self)
             EndTextureMode();
         }
 
-#if IC_OPT_BG_STATIC!=1
-        DrawRectangleGradientEx(
-            (Rectangle){
-                .x = 0.0f,
-                .y = 0.0f,
-                .width = (float)renderer.resolution.x,
-                .height = (float)renderer.resolution.y
-            },
-            compile_time_ic_options.background_color.gradient_top_left,
-            compile_time_ic_options.background_color.gradient_bottom_left,
-            compile_time_ic_options.background_color.gradient_top_right,
-            compile_time_ic_options.background_color.gradient_bottom_right
-        );
-#endif   /* IC_OPT_BG_STATIC */
-
+#if IC_OPT_PARTIAL_REDRAW!=1
         /* Widget render (no value updates). */
-        for (int i = 0; i < num_global_widgets; ++i)
-            global_widgets[i]->draw(global_widgets[i], self);
-
-        /* After drawing all widgets, clear all 'has_update' flags. This will require an atomic operation... */
-        if (CAN.has_update) {
-            for (int i = 0; i < DBC_SIGNALS_LEN; ++i) {
-                if (!DBC.signals[i].real_time_data.has_update) continue;
-
-                pthread_mutex_lock(&DBC.signals[i].real_time_data.lock);
-                DBC.signals[i].real_time_data.has_update = false;
-                pthread_mutex_unlock(&DBC.signals[i].real_time_data.lock);
-            }
+        for (uint32_t i = 0; i < page->num_visible_widgets; ++i)
+            draw_widget(global_widgets[page->visible_widgets[i]], self);
 
-            /* A global bool prevents the drawing thread from needing to loop signals every pass. */
-            pthread_mutex_lock(&CAN.lock);
-            CAN.has_update = false;
-            pthread_mutex_unlock(&CAN.lock);
-        }
+        submit_draw_list();
+#endif   /* IC_OPT_PARTIAL_REDRAW */
 
         if (any_outlines) {
             DrawTexturePro(
@@ -226,21 +638,60 @@ raylib_render_loop(const renderer_t *self)
             time_avg /= (double)compile_time_ic_options.window.fps_limit;
 
             DPRINTLN(">>> Average render time per frame over 1s: %f (%f millis)", time_avg, time_avg * 1000.0f);
+#if IC_OPT_PARTIAL_REDRAW==1
+            DPRINTLN(
+                ">>> Average repainted area per frame over 1s: %.1f%% of the window",
+                100.0 * repainted_fraction / compile_time_ic_options.window.fps_limit
+            );
+            repainted_fraction = 0.0;
+#endif   /* IC_OPT_PARTIAL_REDRAW */
 
             clock_sample_count = 0;
         }
 #endif   /* IC_DEBUG */
 
+#if IC_OPT_PROFILER==1
+        /* The frame total covers all work up to presenting; buffer swap and FPS pacing happen in 'EndDrawing'. */
+        profiler_end_frame(profile_frame_begin_ns);
+        profiler_draw_overlay(self);
+        submit_draw_list();
+#endif   /* IC_OPT_PROFILER */
+
 #if IC_DEBUG==1
         DrawFPS(10, 10);
 #endif   /* IC_DEBUG */
 
         EndDrawing();
+
+        /* Never blocks the CAN threads. */
+        consume_widget_signals(page, widget_is_dirty);
+
+#if IC_OPT_LATENCY_TRACKING==1
+        /* Once a second by the clock: a frame count can't say how long that is with an uncapped (0) fps_limit. */
+        if (latency_now_ns() - latency_reported_ns >= 1000000000ull) {
+            latency_report();
+            latency_reported_ns = latency_now_ns();
+        }
+#endif   /* IC_OPT_LATENCY_TRACKING */
     }
+
+teardown:
 #if IC_DEBUG==1 && IC_OPT_DISABLE_RENDER_TIME!=1
     free(clock_samples);
 #endif   /* IC_OPT_DISABLE_RENDER_TIME */
 
+    free(widget_is_dirty);
+
+#if IC_OPT_STATIC_LAYER==1
+    UnloadRenderTexture(static_layer);
+#endif   /* IC_OPT_STATIC_LAYER */
+
+#if IC_OPT_PARTIAL_REDRAW==1
+    UnloadRenderTexture(framebuffer);
+    free(last_bounds);
+    free(dirty_rects);
+#endif   /* IC_OPT_PARTIAL_REDRAW */
+
     CloseWindow();
 }
 
@@ -3,35 +3,46 @@
 //
 
 #include "widget.h"
+#include "arena.h"
+#include "latency.h"
 
 #include <ctype.h>
 #include <stdio.h>
 #include <string.h>
 
 
-#define DEFINE_STRTOK(name, target, delims) \
-    char *name = strtok(target, delims); \
-    if (NULL == name) { \
-        fprintf(stderr, "ERROR:  Configuration(line %u): Could not determine the value of '" #name "'.\n", line_num); \
-        return ERR_INVALID_CONFIGURATION; \
-    } \
-    name = strdup(name); \
-    if (NULL == name) { \
-        fprintf(stderr, "ERROR:  Configuration(line %u): Failed to duplicate value of '" #name "'.\n", line_num); \
-        return ERR_INVALID_CONFIGURATION; \
-    }
-#define DEFINE_STRTOK_CSV(name) DEFINE_STRTOK(name, NULL, ",")
-#define CONF_SUMMARIZE(x) DPRINTLN("\t\t'" #x "':  '%s'", x);
+widget_t **global_widgets = NULL;
+uint32_t num_global_widgets = 0;
+widget_state_t *widget_states = NULL;
 
-#define CHECK_STRTOL(property) \
-    if (*endptr) { \
-        fprintf(stderr, "ERROR:  Configuration(line %u): Invalid numeric value of '" #property " (value '%s')'.\n", line_num, property); \
-        return ERR_INVALID_CONFIGURATION; \
-    }
+/* Everything 'load_widgets' and the skins allocate, packed together; see 'widget_alloc'. */
+static ic_arena_t widget_arena = {0};
 
+/* One bit per widget (by 'index'): raised by the CAN threads through 'mark_signal_widgets_dirty'. */
+static atomic_uint_fast64_t *dirty_widget_words = NULL;
+static uint32_t num_dirty_widget_words = 0;
 
-widget_t **global_widgets = NULL;
-uint32_t num_global_widgets = 0;
+widget_page_t *widget_pages = NULL;
+uint32_t num_widget_pages = 0;
+
+/* Render thread only. The page signal switches pages only when its value changes. */
+static uint32_t active_page = 0;
+static dbc_signal_t *page_signal = NULL;
+static double last_page_signal_value;
+
+/* A widget shown while its visibility signal is non-zero. Like the page signal, only changes count. */
+typedef
+struct {
+    widget_t *widget;
+    dbc_signal_t *signal;
+    double last_value;
+} visibility_binding_t;
+
+static visibility_binding_t *visibility_bindings = NULL;
+static uint32_t num_visibility_bindings = 0;
+
+/* Render thread only. Bumped by every visibility change. */
+static uint32_t visibility_epoch = 0;
 
 const char *widget_default_skin_name = "default";
 
@@ -53,8 +64,8 @@ static inline bool assign_factory_methods(void);
 uint32_t num_widget_factories;
 
 
-static inline void
-reorder_widgets_map(void);
+static void
+sort_by_z_index(const widget_descriptor_t *descriptors, uint32_t num_descriptors, uint32_t *order);
 
 
 static ic_err_t
@@ -64,106 +75,116 @@ get_signal_by_name(const char *name, dbc_signal_t **signal_out)
 
     *signal_out = NULL;
 
-    for (int i = 0; i < DBC_SIGNALS_LEN; ++i) {
-        if (NULL == DBC.signals[i].name) continue;
-        if (0 == strcmp(name, DBC.signals[i].name)) {
-            *signal_out = &DBC.signals[i];
-            return ERR_OK;
-        }
+    /* Binary search over the generated name index for the first signal not ordered before 'name'. */
+    uint32_t low = 0, high = DBC_SIGNALS_LEN;
+
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+
+        if (strcmp(DBC.signals[DBC.sorted_signal_indices[middle]].name, name) < 0) low = middle + 1;
+        else high = middle;
     }
 
-    return ERR_NOT_FOUND;
+    if (low == DBC_SIGNALS_LEN || 0 != strcmp(DBC.signals[DBC.sorted_signal_indices[low]].name, name))
+        return ERR_NOT_FOUND;
+
+    *signal_out = &DBC.signals[DBC.sorted_signal_indices[low]];
+    return ERR_OK;
+}
+
+
+/*
+ * Attach 'widget' to 'signal': the signal is appended to the widget's parent signals (its channels)
+ *  and the widget to the signal's instances. Both arrays were sized by 'load_widgets' up front.
+ */
+static void
+link_signal(dbc_signal_t *signal, widget_t *widget)
+{
+    widget->parent_signals[widget->num_parent_signals++] = signal;
+    signal->widget_instances[signal->num_widget_instances++] = widget;
 }
 
 
+/*
+ * Let 'signal' show or hide 'widget'. The widget is added to the signal's widget instances (but the
+ *  signal isn't one of the widget's parent signals), so its changes mark the widget dirty.
+ */
+static void
+bind_visibility_signal(dbc_signal_t *signal, widget_t *widget)
+{
+    signal->widget_instances[signal->num_widget_instances++] = widget;
+
+    visibility_bindings[num_visibility_bindings++] = (visibility_binding_t){
+        .widget = widget,
+        .signal = signal,
+        .last_value = rtd_read(&signal->real_time_data),
+    };
+}
+
+
+/* Size every signal's widget instance list exactly, so linking never reallocates. */
 static ic_err_t
-update_signal_and_create_widget(uint32_t line_num, char *rel_signal_name, widget_t **widget_ref)
+allocate_signal_instances(const widget_descriptor_t *descriptors, uint32_t num_descriptors)
 {
-    if (NULL == rel_signal_name || NULL == widget_ref) return ERR_ARGS;
+    for (uint32_t i = 0; i < num_descriptors; ++i) {
+        for (uint32_t s = 0; s < descriptors[i].num_signals; ++s)
+            ++DBC.signals[descriptors[i].signal_indices[s]].num_widget_instances;
 
-    dbc_signal_t *related_signal = NULL;
-    ic_err_t status = get_signal_by_name(rel_signal_name, &related_signal);
-    if (ERR_OK != status || NULL == related_signal) {
-        fprintf(
-            stderr,
-            "ERROR:  Configuration(line %u): Could not find signal '%s' (e:%u).\n",
-            line_num, rel_signal_name, status
-        );
-        return ERR_NOT_FOUND;
+        if (descriptors[i].visibility_signal_index >= 0)
+            ++DBC.signals[descriptors[i].visibility_signal_index].num_widget_instances;
     }
-    DPRINTLN("Located signal '%s' at %p.", rel_signal_name, related_signal);
 
-    /* If the widget ref is currently empty, create a new widget. */
-    if (NULL == *widget_ref) {
-        *widget_ref = calloc(1, sizeof(widget_t));
-        if (NULL == *widget_ref) return ERR_OUT_OF_RESOURCES;
+    for (int i = 0; i < DBC_SIGNALS_LEN; ++i) {
+        if (0 == DBC.signals[i].num_widget_instances) continue;
+
+        DBC.signals[i].widget_instances = widget_alloc(DBC.signals[i].num_widget_instances, sizeof(widget_t *));
+        if (NULL == DBC.signals[i].widget_instances) return ERR_OUT_OF_RESOURCES;
+
+        DBC.signals[i].num_widget_instances = 0;   /* counts back up while linking */
     }
 
-    /* Prepare to attach the widget reference to the signal. */
-    ++related_signal->num_widget_instances;
+    return ERR_OK;
+}
 
-    /* Widget already has an assigned widget (or more than one). */
-    if (related_signal->num_widget_instances > 1) {
-        if (NULL == related_signal->widget_instances) {
-            fprintf(
-                stderr,
-                "ERROR:  Configuration (line %u, signal %s): There are somehow multiple widget instances, but no buffer to contain them.\n",
-                line_num, rel_signal_name
-            );
-        }
 
-        void **new_instance_list = realloc(
-            related_signal->widget_instances, related_signal->num_widget_instances * sizeof(widget_t *)
-        );
-        related_signal->widget_instances = new_instance_list;
+/* Each page's widget list is built once, so switching pages never filters anything. */
+static ic_err_t
+build_widget_pages(void)
+{
+    num_widget_pages = MAX(1, compile_time_ic_options.num_pages);
+    widget_pages = widget_alloc(num_widget_pages, sizeof(widget_page_t));
+    if (NULL == widget_pages) return ERR_OUT_OF_RESOURCES;
 
-        if (NULL == related_signal->widget_instances) {
-            fprintf(
-                stderr,
-                "ERROR:  Configuration(line %u, signal %s): Could not append widget ref to signal - OOM.\n",
-                line_num, rel_signal_name
-            );
-            return ERR_OUT_OF_RESOURCES;
-        }
+    for (uint32_t p = 0; p < num_widget_pages; ++p) {
+        widget_pages[p].widgets = widget_alloc(MAX(1, num_global_widgets), sizeof(uint32_t));
+        widget_pages[p].visible_widgets = widget_alloc(MAX(1, num_global_widgets), sizeof(uint32_t));
+        if (NULL == widget_pages[p].widgets || NULL == widget_pages[p].visible_widgets) return ERR_OUT_OF_RESOURCES;
 
-        related_signal->widget_instances[related_signal->num_widget_instances - 1] = *widget_ref;
-    } else {
-        related_signal->widget_instances = malloc(sizeof(widget_t *));
-        related_signal->widget_instances[0] = *widget_ref;
-    }
+        /* 'global_widgets' is already in z order, and so is each page. */
+        for (uint32_t i = 0; i < num_global_widgets; ++i) {
+            if (WIDGET_PAGE_ALL != global_widgets[i]->page && p != global_widgets[i]->page) continue;
 
-    /* Now, do the inverse for the widget instance. */
-    widget_t *the_widget = *widget_ref;
-    ++the_widget->num_parent_signals;
+            widget_pages[p].widgets[widget_pages[p].num_widgets++] = i;
 
-    /* Widget already has an assigned widget (or more than one). */
-    if (the_widget->num_parent_signals > 1) {
-        if (NULL == the_widget->parent_signals) {
-            fprintf(
-                stderr,
-                "ERROR:  Configuration (line %u, signal %s): There are somehow multiple signal instances, but no buffer to contain them.\n",
-                line_num, rel_signal_name
-            );
+            if (widget_states[i].visible)
+                widget_pages[p].visible_widgets[widget_pages[p].num_visible_widgets++] = i;
         }
+    }
 
-        void **new_instance_list = realloc(
-            the_widget->parent_signals, the_widget->num_parent_signals * sizeof(dbc_signal_t *)
-        );
-        the_widget->parent_signals = (dbc_signal_t **)new_instance_list;
+    if (compile_time_ic_options.default_page_number < 0 || compile_time_ic_options.default_page_number >= num_widget_pages) {
+        fprintf(stderr, "ERROR:  The default page (%d) is not one of the configured pages.\n", compile_time_ic_options.default_page_number);
+        return ERR_INVALID_CONFIGURATION;
+    }
+    active_page = compile_time_ic_options.default_page_number;
 
-        if (NULL == the_widget->parent_signals) {
-            fprintf(
-                stderr,
-                "ERROR:  Configuration(line %u, signal %s): Could not append signal ref to widget - OOM.\n",
-                line_num, rel_signal_name
-            );
-            return ERR_OUT_OF_RESOURCES;
+    if (NULL != compile_time_ic_options.page_signal_name) {
+        if (ERR_OK != get_signal_by_name(compile_time_ic_options.page_signal_name, &page_signal)) {
+            fprintf(stderr, "ERROR:  The page signal '%s' does not exist.\n", compile_time_ic_options.page_signal_name);
+            return ERR_NOT_FOUND;
         }
 
-        the_widget->parent_signals[the_widget->num_parent_signals - 1] = related_signal;
-    } else {
-        the_widget->parent_signals = malloc(sizeof(widget_t *));
-        the_widget->parent_signals[0] = related_signal;
+        /* Only changes to the signal switch pages, so it doesn't override keys (or the default page). */
+        last_page_signal_value = rtd_read(&page_signal->real_time_data);
     }
 
     return ERR_OK;
@@ -171,12 +192,23 @@ update_signal_and_create_widget(uint32_t line_num, char *rel_signal_name, widget
 
 
 ic_err_t
-load_widgets(char *mutable_configuration)
+load_widgets(const widget_descriptor_t *descriptors, uint32_t num_descriptors)
 {
     ic_err_t status;
 
-    char *loaded_widgets = strdup(IC_WIDGETS);
-    DPRINTLN("loaded_widgets:  '%s'", loaded_widgets);
+    /* Split in place; the factory names point into this copy. */
+    char *loaded_widgets = arena_strdup(&widget_arena, IC_WIDGETS);
+    DPRINTLN("loaded_widgets:  '%s'", IC_WIDGETS);
+
+    /* No more names than commas, plus one. */
+    uint32_t max_widget_factories = 1;
+    for (const char *c = IC_WIDGETS; '\0' != *c; ++c) max_widget_factories += ',' == *c;
+
+    widget_factories = widget_alloc(max_widget_factories, sizeof(registered_widget_factory_t));
+    if (NULL == loaded_widgets || NULL == widget_factories) {
+        fprintf(stderr, "ERROR: Failed to allocate widget-type registrations - OOM.\n");
+        return ERR_OUT_OF_RESOURCES;
+    }
 
     char *str_walk = strtok(loaded_widgets, ",");
     if (NULL == str_walk) {
@@ -185,21 +217,9 @@ load_widgets(char *mutable_configuration)
     }
 
     num_widget_factories = 0;
-    widget_factories = malloc(1);   /* placeholder for initialization */
 
     do {
-        ++num_widget_factories;
-
-        registered_widget_factory_t *new_widget_factories
-            = realloc(widget_factories, num_widget_factories * sizeof(registered_widget_factory_t));
-        if (NULL == new_widget_factories) {
-            fprintf(stderr, "ERROR: Failed to reallocate widget-type registrations - OOM.\n");
-            free(loaded_widgets); free(widget_factories);
-            return ERR_OUT_OF_RESOURCES;
-        }
-        widget_factories = new_widget_factories;
-
-        widget_factories[num_widget_factories - 1].name = strdup(str_walk);
+        widget_factories[num_widget_factories++].name = str_walk;
     } while (NULL != (str_walk = strtok(NULL, ",")));
 
     if (MAX_REGISTRATIONS <= num_widget_factories) {
@@ -219,164 +239,105 @@ load_widgets(char *mutable_configuration)
 
     /*
      * Load widgets and init them.
-     *  Widgets are specifically tied to signals by name. An example configuration line might show:
-     *          Signal_5060_4,Vehicle Speed,needle_meter,true,20,20,200,200,0,
-     *              180:-50:0:120:20:5:10:MONOSPACE:DIAMOND:GROOVE:80:FD6611AA:DDDDDFF:DD9999CC:mph:100:60
-     *      SIGNAL_NAME(S),WIDGET_LABEL,WIDGET_TYPE[:SKIN],VISIBLE,X,Y,W,H,Z-INDEX,WIDGET_OPTS (specific to each widget)
-     *      In the case of the needle meter's default skin, we have...
-     *          DEGREES:TILT_DEGREES:MIN:MAX:INTERVAL:SUB_INTERVAL:FONT_SIZE:FONT_TYPE:NEEDLE_TYPE:BEZEL_TYPE\
-     *              :NEEDLE_PERC:NEEDLE_RGBA:BEZEL_RGBA:NUMBERS_RGBA:UNIT_LABEL:LABEL_OFFSET(X:Y)
-     *      These custom properties are documented in the FlexIC project, or in the respective widget source.
+     *  Each widget comes from a descriptor which the configuration generator fully resolved at build
+     *  time (see 'widget_descriptor_t' and the generated 'config.c'): its signals are indices into
+     *  'DBC.signals' (a misspelled signal fails the build), its fields are typed, and its options are
+     *  pre-parsed into every form they can take. Loading only links widgets and signals together,
+     *  with every array allocated once at its final size. Strings stay in the descriptors.
      *
-     * A widget is uniquely instantiated for each signal that has one to display. That way, when
-     *  CAN messages are received with the corresponding signals, data can be modified and signals
-     *  can cause a redraw of the component. The logic of the message's `update` hook will control
-     *  whether the widget will be forced to fully redraw, go invisible, etc.
+     * A widget is uniquely instantiated for each descriptor. Its signals are linked both ways, so
+     *  CAN messages received with those signals mark the widget dirty for its next 'update', and the
+     *  widget reads them through its channels (in 'signal_indices' order).
      */
-    global_widgets = malloc(sizeof(widget_t *));
-    num_global_widgets = 0;
-
-    uint32_t line_num = 0;
-    uint32_t line_len = 0;
-    char *line = strtok(mutable_configuration, "\n");
-
-    do {
-        ++line_num;
-        line_len = strlen(line);   /* preserve the original line length */
-
-        DEFINE_STRTOK(signal_name, line, ",");
-        DEFINE_STRTOK_CSV(widget_label);
-        DEFINE_STRTOK_CSV(widget_type);
-        DEFINE_STRTOK_CSV(visible);
-        DEFINE_STRTOK_CSV(x_pos);
-        DEFINE_STRTOK_CSV(y_pos);
-        DEFINE_STRTOK_CSV(width);
-        DEFINE_STRTOK_CSV(height);
-        DEFINE_STRTOK_CSV(rotation);
-        DEFINE_STRTOK_CSV(z_index);
-        DEFINE_STRTOK_CSV(draws_outline);
-        DEFINE_STRTOK_CSV(widget_opts);
-
-        /* Debugging information only; will not show in non-debug builds. */
-        DPRINTLN("Config summary (line %u):", line_num);
-        CONF_SUMMARIZE(signal_name);
-        CONF_SUMMARIZE(widget_label);
-        CONF_SUMMARIZE(widget_type);
-        CONF_SUMMARIZE(visible);
-        CONF_SUMMARIZE(x_pos);
-        CONF_SUMMARIZE(y_pos);
-        CONF_SUMMARIZE(width);
-        CONF_SUMMARIZE(height);
-        CONF_SUMMARIZE(rotation);
-        CONF_SUMMARIZE(z_index);
-        CONF_SUMMARIZE(draws_outline);
-        CONF_SUMMARIZE(widget_opts);
-
-        /* Quickly get the skin name, if defined. */
-        char *skin_name = strtok(widget_type, ":");
-        if (NULL == (skin_name = strtok(NULL, ":"))) {
-            skin_name = (char *)DEFAULT_SKIN;
-        }
-        CONF_SUMMARIZE(skin_name);
-        DPRINT("\n");
-
-        /* Fetch the related signal by name. */
-        /* NOTE: This operation might take a while for many signals, but the mapping only needs to be done once. */
-        char *rel_signal_name = strtok(signal_name, ":");
-        if (NULL == rel_signal_name) {
-            fprintf(stderr, "ERROR:  Configuration(line %u): Failed to get a valid signal name.\n", line_num);
-            return ERR_INVALID_CONFIGURATION;
-        }
-
-        /* Correlate the widget to its specified signals. Also returns a new widget. */
-        widget_t *new_widget = NULL;
-        do {
-            status = update_signal_and_create_widget(line_num, rel_signal_name, &new_widget);
-            if (ERR_OK != status) return status;
-        } while (NULL != (rel_signal_name = strtok(NULL, ":")));
+    if (0 == num_descriptors) {
+        fprintf(stderr, "ERROR: No widgets are configured. FlexIC is useless without widgets.\n");
+        return ERR_INVALID_CONFIGURATION;
+    }
 
-        if (NULL == new_widget) {
-            fprintf(stderr, "ERROR:  Configuration(line %u): NULL widgets are not permitted.\n", line_num);
-            return ERR_NOT_FOUND;
-        }
-        DPRINTLN("widget:  Loaded %u signal references.", new_widget->num_parent_signals);
-
-        /* Add the new (shared) widget instance reference to the flat global list. */
-        ++num_global_widgets;
-        widget_t **new_global_widgets = realloc(global_widgets, num_global_widgets * sizeof(widget_t *));
-        global_widgets = new_global_widgets;
-        if (NULL == global_widgets) {
-            fprintf(stderr, "ERROR:  Failed to reallocate the flat list of global widgets.\n");
-            return ERR_OUT_OF_RESOURCES;
-        }
-        DPRINTLN("global_widgets: Update index %u", (num_global_widgets - 1));
-        global_widgets[num_global_widgets - 1] = new_widget;
-
-        /* Initialize as much as we can before handing control to the factory method for the specific widget type. */
-        char *endptr = NULL;
-        new_widget->type = strdup(widget_type);
-        new_widget->label = strdup(widget_label);
-        new_widget->skin_name = strdup(skin_name);
-        new_widget->state.visible = 0 == strcasecmp(visible, "yes");
-        new_widget->state.resolution.x = (int)strtol(width, &endptr, 10);   CHECK_STRTOL(width);
-        new_widget->state.resolution.y = (int)strtol(height, &endptr, 10);  CHECK_STRTOL(height);
-        new_widget->state.position.x = (int)strtol(x_pos, &endptr, 10);     CHECK_STRTOL(x_pos);
-        new_widget->state.position.y = (int)strtol(y_pos, &endptr, 10);     CHECK_STRTOL(y_pos);
-        new_widget->state.rotation = (float)strtof(rotation, &endptr);           CHECK_STRTOL(rotation);
-        new_widget->state.z_index = (int)strtol(z_index, &endptr, 10);      CHECK_STRTOL(z_index);
-        new_widget->draw_outline = (0 == strcmp(draws_outline, "yes"));
+    uint32_t num_signal_refs = 0;
+    uint32_t num_bindings = 0;
 
-        /* Locate the factory method for the widget_type. */
-        bool created = false;
-        for (int i = 0; i < num_widget_factories; ++i) {
-            if (__builtin_expect(NULL == widget_factories[i].name || NULL == widget_factories[i].create, false)) continue;
-
-            if (__builtin_expect(0 != strcmp(widget_type, widget_factories[i].name), true)) continue;
+    for (uint32_t i = 0; i < num_descriptors; ++i) {
+        num_signal_refs += descriptors[i].num_signals;
+        if (descriptors[i].visibility_signal_index >= 0) ++num_bindings;
+    }
 
-            /* Create the params/args details for the new widget from the options string (delimited by ':'). */
-            int argc = 0;
-            key_value_t **argv = NULL;
+    /*
+     * From the widget arena, like everything else loaded here: the widgets end up next to each other, with the skins' parameters right behind them.
+     *  Widgets are created in z order, so their states, the widgets themselves and every list of them are all walked front to back by a frame.
+     */
+    uint32_t *order = widget_alloc(num_descriptors, sizeof(uint32_t));
+    widget_states = widget_alloc(num_descriptors, sizeof(widget_state_t));
+    widget_t *widgets = widget_alloc(num_descriptors, sizeof(widget_t));
+    dbc_signal_t **signal_refs = widget_alloc(MAX(1, num_signal_refs), sizeof(dbc_signal_t *));
+    global_widgets = widget_alloc(num_descriptors, sizeof(widget_t *));
+    visibility_bindings = widget_alloc(MAX(1, num_bindings), sizeof(visibility_binding_t));
+
+    if (NULL == order || NULL == widget_states || NULL == widgets || NULL == signal_refs || NULL == global_widgets || NULL == visibility_bindings) {
+        fprintf(stderr, "ERROR:  Failed to allocate the widgets - OOM.\n");
+        return ERR_OUT_OF_RESOURCES;
+    }
 
-            char *token = strtok(widget_opts, ";");
-            int token_length = 0;
-            if (NULL != token) {
-                argv = malloc(sizeof(key_value_t *));   /* placeholder - not actually supposed to do anything */
-                if (NULL == argv) return ERR_OUT_OF_RESOURCES;
+    if (ERR_OK != (status = allocate_signal_instances(descriptors, num_descriptors))) {
+        fprintf(stderr, "ERROR:  Failed to allocate the signals' widget references - OOM.\n");
+        return status;
+    }
 
-                do {
-                    token_length = strlen(token);
+    sort_by_z_index(descriptors, num_descriptors, order);
 
-                    key_value_t **temp_argv = realloc(argv, sizeof(key_value_t *) * (argc + 1));
-                    if (NULL == temp_argv) return ERR_OUT_OF_RESOURCES;
-                    argv = temp_argv;
+    for (uint32_t i = 0; i < num_descriptors; ++i) {
+        uint32_t d = order[i];
+        const widget_descriptor_t *descriptor = &descriptors[d];
+        widget_t *new_widget = &widgets[i];
 
-                    argv[argc] = malloc(sizeof(key_value_t));
-                    if (NULL == argv[argc]) return ERR_OUT_OF_RESOURCES;
+        new_widget->index = i;
+        new_widget->state = &widget_states[i];
+        new_widget->type = descriptor->type;
+        new_widget->label = descriptor->label;
+        new_widget->skin_name = descriptor->skin_name;
+        new_widget->options = descriptor->options;
+        new_widget->num_options = descriptor->num_options;
+        new_widget->page = descriptor->page;
+        new_widget->draw_outline = descriptor->draw_outline;
+        new_widget->state->visible = descriptor->visible;
+        new_widget->state->position = descriptor->position;
+        new_widget->state->resolution = descriptor->resolution;
+        new_widget->state->rotation = descriptor->rotation;
+        new_widget->state->z_index = descriptor->z_index;
 
-                    argv[argc]->key = strdup(strtok(token, "="));
+        new_widget->parent_signals = signal_refs;
+        signal_refs += descriptor->num_signals;
 
-                    char *arg_value = strtok(NULL, "=");
-                    argv[argc]->value = NULL != arg_value ? strdup(arg_value) : NULL;
+        for (uint32_t s = 0; s < descriptor->num_signals; ++s)
+            link_signal(&DBC.signals[descriptor->signal_indices[s]], new_widget);
 
-                    ++argc;
-                } while (NULL != (token = strtok(&token[token_length + 1], ";")));
-            }
+        if (descriptor->visibility_signal_index >= 0)
+            bind_visibility_signal(&DBC.signals[descriptor->visibility_signal_index], new_widget);
 
-            new_widget->argc = argc;
-            new_widget->argv = argv;
+        global_widgets[num_global_widgets++] = new_widget;
 
 #if IC_DEBUG==1
-            DPRINTLN("Line %u parameters (%u):", line_num, argc);
-            for (int i = 0; i < argc; i++) {
-                DPRINTLN("\t>>> arg[%02u]:  '%s' = '%s'", i, argv[i]->key, argv[i]->value);
-            }
+        DPRINTLN(
+            "Widget %u: '%s' (%s:%s) with %u signal(s) and %u option(s).",
+            d, new_widget->label, new_widget->type, new_widget->skin_name, new_widget->num_parent_signals, new_widget->num_options
+        );
+        for (uint32_t i = 0; i < new_widget->num_options; i++) {
+            DPRINTLN("\t>>> arg[%02u]:  '%s' = '%s'", i, new_widget->options[i].key, new_widget->options[i].text);
+        }
 #endif   /* IC_DEBUG */
 
+        /* Locate the factory method for the widget_type. */
+        bool created = false;
+        for (int i = 0; i < num_widget_factories; ++i) {
+            if (__builtin_expect(NULL == widget_factories[i].name || NULL == widget_factories[i].create, false)) continue;
+
+            if (__builtin_expect(0 != strcmp(descriptor->type, widget_factories[i].name), true)) continue;
+
             if (ERR_OK != (status = widget_factories[i].create(new_widget))) {
                 fprintf(
                     stderr,
-                    "ERROR:  Failed to instantiate widget type '%s' for signal '%s' (e:%u).\n",
-                    widget_type, signal_name, status
+                    "ERROR:  Failed to instantiate widget type '%s' for widget '%s' (e:%u).\n",
+                    descriptor->type, descriptor->label, status
                 );
                 return status;
             }
@@ -387,32 +348,261 @@ load_widgets(char *mutable_configuration)
         if (!created) {
             fprintf(
                 stderr,
-                "ERROR:  Configuration (line %u): Invalid 'widget_type' name '%s'.\n\t\tDid you forget to add the widget type to the compiler options?\n",
-                line_num, widget_type
+                "ERROR:  Configuration (widget '%s'): Invalid 'widget_type' name '%s'.\n\t\tDid you forget to add the widget type to the compiler options?\n",
+                descriptor->label, descriptor->type
             );
             return ERR_INVALID_WIDGET_TYPE;
         }
+    }
 
-        /* Free up variables. */
-        free(signal_name);
-        free(widget_label);
-        free(widget_type);
-        free(visible);
-        free(x_pos);
-        free(y_pos);
-        free(width);
-        free(height);
-        free(rotation);
-        free(z_index);
-        free(widget_opts);
-    } while (NULL != (line = strtok(&line[line_len + 1], "\n")));
-
-    DPRINTLN("global_widgets: Created and populated a flat list of %u widget references.", num_global_widgets);
-
-    reorder_widgets_map();
-    DPRINTLN("global_widgets: Re-ordered based on ascending Z-INDEX.");
+    DPRINTLN("global_widgets: Created and populated a flat list of %u widget references, in ascending Z-INDEX order.", num_global_widgets);
 
-    return ERR_OK;
+    /* Every widget starts out dirty, so the first frame updates them all. */
+    num_dirty_widget_words = (num_global_widgets + 63) / 64;
+    dirty_widget_words = widget_alloc(num_dirty_widget_words, sizeof(atomic_uint_fast64_t));
+    if (NULL == dirty_widget_words) return ERR_OUT_OF_RESOURCES;
+
+    for (uint32_t i = 0; i < num_global_widgets; ++i) {
+        atomic_fetch_or_explicit(&dirty_widget_words[i / 64], 1ull << (i % 64), memory_order_relaxed);
+    }
+
+    return build_widget_pages();
+}
+
+
+void *
+widget_alloc(size_t count, size_t size)
+{
+    return arena_alloc(&widget_arena, count, size);
+}
+
+
+void
+mark_signal_widgets_dirty(const dbc_signal_t *signal)
+{
+    for (int i = 0; i < signal->num_widget_instances; ++i) {
+        uint32_t index = ((widget_t *)signal->widget_instances[i])->index;
+        atomic_fetch_or_explicit(&dirty_widget_words[index / 64], 1ull << (index % 64), memory_order_release);
+    }
+}
+
+
+uint32_t
+take_dirty_widgets(bool *out_dirty)
+{
+    uint32_t count = 0;
+
+    memset(out_dirty, 0, num_global_widgets * sizeof(bool));
+
+    for (uint32_t w = 0; w < num_dirty_widget_words; ++w) {
+        uint64_t bits = atomic_exchange_explicit(&dirty_widget_words[w], 0, memory_order_acquire);
+
+        for (; 0 != bits; bits &= bits - 1, ++count)
+            out_dirty[w * 64 + __builtin_ctzll(bits)] = true;
+    }
+
+    return count;
+}
+
+
+/*
+ * Only widgets updated this frame can be showing new values, so only their signals are visited.
+ *  Latency is taken first, since widgets may share a signal.
+ */
+void
+consume_widget_signals(const widget_page_t *page, const bool *widget_is_dirty)
+{
+#if IC_OPT_LATENCY_TRACKING==1
+    /* Every widget showing a fresh value counts once: receive-to-presentation is what the driver sees. */
+    uint64_t shown_ns = latency_now_ns();
+
+    for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+        if (!widget_is_dirty[page->visible_widgets[i]]) continue;
+
+        const widget_t *widget = global_widgets[page->visible_widgets[i]];
+
+        for (uint32_t s = 0; s < widget->num_parent_signals; ++s) {
+            const real_time_data_t *rtd = &widget->parent_signals[s]->real_time_data;
+            if (!rtd_has_update(rtd)) continue;
+
+            uint64_t rx_time_ns = rtd_read_rx_time(rtd);
+            latency_record(shown_ns > rx_time_ns ? shown_ns - rx_time_ns : 0, 1);
+        }
+    }
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+    for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+        if (!widget_is_dirty[page->visible_widgets[i]]) continue;
+
+        const widget_t *widget = global_widgets[page->visible_widgets[i]];
+
+        for (uint32_t s = 0; s < widget->num_parent_signals; ++s)
+            rtd_consume(&widget->parent_signals[s]->real_time_data);
+    }
+}
+
+
+
+const widget_page_t *
+active_widget_page(void)
+{
+    return &widget_pages[active_page];
+}
+
+
+uint32_t
+active_widget_page_number(void)
+{
+    return active_page;
+}
+
+
+bool
+switch_widget_page(uint32_t page)
+{
+    if (page >= num_widget_pages || page == active_page) return false;
+
+    active_page = page;
+
+    /* Off-page widgets are never updated, so the incoming ones may be showing stale values. */
+    for (uint32_t i = 0; i < widget_pages[page].num_widgets; ++i) {
+        uint32_t index = widget_pages[page].widgets[i];
+        atomic_fetch_or_explicit(&dirty_widget_words[index / 64], 1ull << (index % 64), memory_order_relaxed);
+    }
+
+    DPRINTLN("Switched to page %u.", page);
+    return true;
+}
+
+
+bool
+set_widget_visible(widget_t *widget, bool visible)
+{
+    if (visible == widget->state->visible) return false;
+
+    widget->state->visible = visible;
+    ++visibility_epoch;
+
+    for (uint32_t p = 0; p < num_widget_pages; ++p) {
+        if (WIDGET_PAGE_ALL != widget->page && p != widget->page) continue;
+
+        widget_page_t *page = &widget_pages[p];
+
+        /* Visible lists stay in z order ('index' order), so find where the widget is or belongs. */
+        uint32_t at = 0;
+        while (at < page->num_visible_widgets && page->visible_widgets[at] < widget->index) ++at;
+
+        if (visible) {
+            memmove(&page->visible_widgets[at + 1], &page->visible_widgets[at], (page->num_visible_widgets - at) * sizeof(uint32_t));
+            page->visible_widgets[at] = widget->index;
+            ++page->num_visible_widgets;
+        } else {
+            --page->num_visible_widgets;
+            memmove(&page->visible_widgets[at], &page->visible_widgets[at + 1], (page->num_visible_widgets - at) * sizeof(uint32_t));
+        }
+    }
+
+    return true;
+}
+
+
+uint32_t
+widget_visibility_epoch(void)
+{
+    return visibility_epoch;
+}
+
+
+void
+apply_visibility_signals(bool *widget_is_dirty)
+{
+    for (uint32_t i = 0; i < num_visibility_bindings; ++i) {
+        visibility_binding_t *binding = &visibility_bindings[i];
+        if (!widget_is_dirty[binding->widget->index]) continue;
+
+        double value = rtd_read(&binding->signal->real_time_data);
+        if (value == binding->last_value) continue;
+
+        binding->last_value = value;
+        set_widget_visible(binding->widget, 0.0 != value);
+    }
+}
+
+
+#if IC_OPT_PARTIAL_REDRAW==1
+/* Without explicit 'bounds', assume the widget's rectangle rotated about its top-left corner. */
+static Rectangle
+widget_bounds(const widget_state_t *state)
+{
+    if (state->bounds.resolution.x > 0 && state->bounds.resolution.y > 0) {
+        return (Rectangle){
+            state->bounds.position.x, state->bounds.position.y, state->bounds.resolution.x, state->bounds.resolution.y
+        };
+    }
+
+    float c = cosf(state->rotation * DEG2RAD), s = sinf(state->rotation * DEG2RAD);
+    float xs[4] = { 0, state->resolution.x * c, -state->resolution.y * s, state->resolution.x * c - state->resolution.y * s };
+    float ys[4] = { 0, state->resolution.x * s, state->resolution.y * c, state->resolution.x * s + state->resolution.y * c };
+    float min_x = xs[0], max_x = xs[0], min_y = ys[0], max_y = ys[0];
+
+    for (int i = 1; i < 4; ++i) {
+        min_x = MIN(min_x, xs[i]); max_x = MAX(max_x, xs[i]);
+        min_y = MIN(min_y, ys[i]); max_y = MAX(max_y, ys[i]);
+    }
+
+    return (Rectangle){ state->position.x + min_x, state->position.y + min_y, max_x - min_x, max_y - min_y };
+}
+
+
+Rectangle
+widget_screen_bounds(const widget_state_t *state, const renderer_t *renderer)
+{
+    Rectangle rect = widget_bounds(state);
+
+    float left = CLAMP(floorf(rect.x), 0, renderer->resolution.x);
+    float top = CLAMP(floorf(rect.y), 0, renderer->resolution.y);
+    float right = CLAMP(ceilf(rect.x + rect.width), 0, renderer->resolution.x);
+    float bottom = CLAMP(ceilf(rect.y + rect.height), 0, renderer->resolution.y);
+
+    return (Rectangle){ left, top, right - left, bottom - top };
+}
+
+
+int
+merge_dirty_rects(Rectangle *rects, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        for (int j = i + 1; j < count; ++j) {
+            if (!CheckCollisionRecs(rects[i], rects[j])) continue;
+
+            float right = MAX(rects[i].x + rects[i].width, rects[j].x + rects[j].width);
+            float bottom = MAX(rects[i].y + rects[i].height, rects[j].y + rects[j].height);
+            rects[i].x = MIN(rects[i].x, rects[j].x);
+            rects[i].y = MIN(rects[i].y, rects[j].y);
+            rects[i].width = right - rects[i].x;
+            rects[i].height = bottom - rects[i].y;
+
+            /* The grown rectangle may now reach ones already passed over, so start its scan again. */
+            rects[j] = rects[--count];
+            j = i;
+        }
+    }
+
+    return count;
+}
+#endif   /* IC_OPT_PARTIAL_REDRAW */
+
+
+bool
+poll_page_signal(void)
+{
+    if (NULL == page_signal) return false;
+
+    double value = rtd_read(&page_signal->real_time_data);
+    if (value == last_page_signal_value) return false;
+
+    last_page_signal_value = value;
+    return value >= 0.0 && switch_widget_page((uint32_t)value);
 }
 
 
@@ -467,41 +657,166 @@ set_hooks_for_skin(
 }
 
 
-char *
-get_option_by_key(widget_t *self, const char *name)
+const widget_option_t *
+get_option_by_key(const widget_t *self, const char *name)
 {
-    for (int i = 0; i < self->argc; i++) {
-        if (NULL == self->argv[i]) return NULL;   /* apparent end of list */
+    for (uint32_t i = 0; i < self->num_options; i++) {
+        if (0 != strcmp(name, self->options[i].key)) continue;
 
-        if (0 != strcmp(name, self->argv[i]->key)) continue;
-
-        return self->argv[i]->value;
+        return &self->options[i];
     }
 
     return NULL;
 }
 
 
-static inline void
-reorder_widgets_map(void)
+static const char *
+option_type_name(widget_option_type_t type)
+{
+    switch (type) {
+        case OPTION_FLOAT:  return "a number";
+        case OPTION_INT:    return "a number";
+        case OPTION_BOOL:   return "a boolean";
+        case OPTION_TEXT:   return "text";
+        case OPTION_COLOR:  return "an RRGGBBAA color";
+        case OPTION_COORDS: return "'X:Y' coordinates";
+        default:            return "an unknown type";
+    }
+}
+
+
+/* Store one configured option into its field. Returns false if it wasn't parsed into the form the field needs. */
+static bool
+store_option(const widget_t *self, const widget_option_schema_t *entry, const widget_option_t *option, uint8_t *field)
+{
+    switch (entry->type) {
+        case OPTION_FLOAT:
+            if (!option->is_number) return false;
+            *(float *)field = (float)option->number;
+            return true;
+        case OPTION_INT:
+            if (!option->is_number) return false;
+            *(int *)field = (int)option->number;
+            return true;
+        case OPTION_BOOL:
+            *(bool *)field = option->boolean;
+            return true;
+        case OPTION_TEXT:
+            *(const char **)field = option->text;
+            return true;
+        case OPTION_COLOR:
+            if (!option->is_color) return false;
+            *(Color *)field = option->color;
+            return true;
+        case OPTION_COORDS:
+            if (!option->is_coords) return false;
+            *(vec2_t *)field = (vec2_t){
+                .x = (int32_t)(option->x.is_percent ? (option->x.value / 100.0) * self->state->resolution.x : option->x.value),
+                .y = (int32_t)(option->y.is_percent ? (option->y.value / 100.0) * self->state->resolution.y : option->y.value)
+            };
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+static void
+store_default(const widget_option_schema_t *entry, uint8_t *field)
 {
-    /* Chad-grade Bubblesort because I'm lazy. */
-    uint32_t comparisons = num_global_widgets;
-    while (comparisons > 0) {
-        for (int i = 0; i < comparisons - 1; ++i) {
-            if (global_widgets[i]->state.z_index > global_widgets[i + 1]->state.z_index) {
-                widget_t *tmp = global_widgets[i];
-                global_widgets[i] = global_widgets[i + 1];
-                global_widgets[i + 1] = tmp;
+    switch (entry->type) {
+        case OPTION_FLOAT:  *(float *)field = entry->fallback.number; break;
+        case OPTION_INT:    *(int *)field = (int)entry->fallback.number; break;
+        case OPTION_BOOL:   *(bool *)field = entry->fallback.boolean; break;
+        case OPTION_TEXT:   *(const char **)field = entry->fallback.text; break;
+        case OPTION_COLOR:  *(Color *)field = entry->fallback.color; break;
+        case OPTION_COORDS: *(vec2_t *)field = entry->fallback.coords; break;
+        default: break;
+    }
+}
+
+
+ic_err_t
+parse_widget_options(
+    const widget_t *self,
+    const widget_option_schema_t *schema,
+    uint32_t schema_length,
+    void *out_params
+) {
+    uint32_t num_errors = 0;
+    uint32_t o = 0, s = 0;
+
+    /* A merge of two sorted lists: at each step, the smaller key is either unknown or missing. */
+    while (o < self->num_options || s < schema_length) {
+        const widget_option_t *option = o < self->num_options ? &self->options[o] : NULL;
+        const widget_option_schema_t *entry = s < schema_length ? &schema[s] : NULL;
+
+        if (NULL != entry && s > 0 && strcmp(schema[s - 1].key, entry->key) >= 0) {
+            fprintf(stderr, "FATAL:  widget(%s, %s): The skin's option schema is not sorted at '%s'.\n", self->label, self->type, entry->key);
+            return ERR_ARGS;
+        }
+
+        if (NULL != option && o > 0 && strcmp(self->options[o - 1].key, option->key) >= 0) {
+            fprintf(stderr, "FATAL:  widget(%s, %s): The configured options are not sorted; regenerate the configuration.\n", self->label, self->type);
+            return ERR_ARGS;
+        }
+
+        int order = NULL == option ? 1 : (NULL == entry ? -1 : strcmp(option->key, entry->key));
+
+        if (order < 0) {
+            fprintf(stderr, "WARNING:  widget(%s, %s): Option '%s' is not used by skin '%s'.\n", self->label, self->type, option->key, self->skin_name);
+            ++o;
+            continue;
+        }
+
+        uint8_t *field = (uint8_t *)out_params + entry->offset;
+
+        if (order > 0) {
+            if (entry->has_default) {
+                store_default(entry, field);
+            } else {
+                fprintf(stderr, "ERROR:  widget(%s, %s): Required option '%s' is missing.\n", self->label, self->type, entry->key);
+                ++num_errors;
             }
+
+            ++s;
+            continue;
+        }
+
+        if (!store_option(self, entry, option, field)) {
+            fprintf(
+                stderr, "ERROR:  widget(%s, %s): Option '%s' = '%s' is not %s.\n",
+                self->label, self->type, option->key, option->text, option_type_name(entry->type)
+            );
+            ++num_errors;
         }
-        --comparisons;;
+
+        DPRINTLN("[%s] option '%s' = '%s'", self->label, option->key, option->text);
+        ++o;
+        ++s;
+    }
+
+    return 0 == num_errors ? ERR_OK : ERR_ARGS;
+}
+
+
+/* The descriptors' indices by ascending z-index. Stable, so widgets with equal z-indices keep their configured order. */
+static void
+sort_by_z_index(const widget_descriptor_t *descriptors, uint32_t num_descriptors, uint32_t *order)
+{
+    for (uint32_t d = 0; d < num_descriptors; ++d) {
+        uint32_t at = d;
+
+        for (; at > 0 && descriptors[order[at - 1]].z_index > descriptors[d].z_index; --at)
+            order[at] = order[at - 1];
+
+        order[at] = d;
     }
 
 #if IC_DEBUG==1
     DPRINTLN("Sorted z-index values:"); DPRINT("\t\t");
-    for (int i = 0; i < num_global_widgets; ++i) {
-        printf("%u ", global_widgets[i]->state.z_index);
+    for (uint32_t i = 0; i < num_descriptors; ++i) {
+        printf("%u ", descriptors[order[i]].z_index);
     }
     printf("\n");
 #endif   /* IC_DEBUG */
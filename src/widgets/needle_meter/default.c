@@ -1,7 +1,6 @@
 #include "widget_common.h"
 
 #include <math.h>
-#include <raylib.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -49,9 +48,9 @@ struct draw_params
     int label_text_size;
     bool has_labels;
 
-    char *unit_text;
+    const char *unit_text;
     int unit_text_size;
-    struct { int x; int y; } unit_text_position;
+    vec2_t unit_text_position;
 
     Color backdrop_color;
     Color border_color;
@@ -60,25 +59,32 @@ struct draw_params
 
     /* NOT CONFIGURED FROM OPTIONS. */
     /* Updated and initialized as part of drawing. */
-    RenderTexture2D static_texture;
-    RenderTexture2D needle_texture;
+    ic_canvas_t static_canvas;
+    ic_canvas_t needle_canvas;
     float needle_degrees;
 };
 
 
+static void
+needle_meter__default__draw_static(widget_t *self, const renderer_t *renderer);
+
+
 static ic_err_t
 needle_meter__default__init(widget_t *self, const renderer_t *renderer)
 {
     char label_value[16] = {0};
 
-    struct draw_params *local_params = (struct draw_params *)(self->state.internal);
+    struct draw_params *local_params = (struct draw_params *)(self->state->internal);
 
-    local_params->static_texture = LoadRenderTexture(MY_WIDTH, MY_HEIGHT);
-    local_params->needle_texture = LoadRenderTexture(MY_WIDTH, MY_HEIGHT);
+    local_params->static_canvas = renderer->canvas_create(renderer, MY_WIDTH, MY_HEIGHT);
+    local_params->needle_canvas = renderer->canvas_create(renderer, MY_WIDTH, MY_HEIGHT);
 
-    BeginTextureMode(local_params->static_texture);
+    if (0 == local_params->static_canvas || 0 == local_params->needle_canvas) return ERR_OUT_OF_RESOURCES;
 
-    DrawRing(
+    renderer->canvas_begin(renderer, local_params->static_canvas);
+
+    draw_ring(
+        renderer,
         local_params->center,
         local_params->inner_radius,
         local_params->outer_radius,
@@ -128,7 +134,8 @@ needle_meter__default__init(widget_t *self, const renderer_t *renderer)
                 : (Color){ .r = 0xFF, .g = 0, .b = 0, .a = 0xFF };
         } else tick_color = local_params->tick_color;
 
-        DrawLineEx(
+        draw_line(
+            renderer,
             (Vector2){inner_x, inner_y},
             (Vector2){outer_x, outer_y},
             is_major_tick ? local_params->tick_thickness : local_params->sub_tick_thickness,
@@ -137,17 +144,18 @@ needle_meter__default__init(widget_t *self, const renderer_t *renderer)
 
         if (is_major_tick && local_params->has_labels) {
             snprintf(label_value, 16, "%i", (int)floor(value_at_tick));
-            DrawText(
+            draw_text(
+                renderer,
                 label_value,
-                label_x,
-                label_y,
+                (Vector2){ label_x, label_y },
                 local_params->label_text_size,
                 local_params->tick_color
             );
         }
     }
 
-    DrawRingLines(
+    draw_ring_lines(
+        renderer,
         local_params->center,
         local_params->inner_radius,
         local_params->outer_radius,
@@ -157,18 +165,18 @@ needle_meter__default__init(widget_t *self, const renderer_t *renderer)
         local_params->border_color
     );
 
-    DrawText(
+    draw_text(
+        renderer,
         local_params->unit_text,
-        local_params->unit_text_position.x,
-        local_params->unit_text_position.y,
+        (Vector2){ local_params->unit_text_position.x, local_params->unit_text_position.y },
         local_params->unit_text_size,
         local_params->text_color
     );
 
-    EndTextureMode();
+    renderer->canvas_end(renderer);
 
 
-    BeginTextureMode(local_params->needle_texture);
+    renderer->canvas_begin(renderer, local_params->needle_canvas);
 
     local_params->needle_degrees = 0.0f;
     float needle_x = local_params->center.x +
@@ -176,7 +184,8 @@ needle_meter__default__init(widget_t *self, const renderer_t *renderer)
     float needle_y = local_params->center.y +
         (local_params->outer_radius - 10) * sinf(local_params->needle_degrees);
 
-    DrawLineEx(
+    draw_line(
+        renderer,
         (Vector2){ local_params->center.x, local_params->center.y },
         (Vector2){ needle_x, needle_y },
         4.0f,   // TODO: Needle styles.
@@ -184,13 +193,17 @@ needle_meter__default__init(widget_t *self, const renderer_t *renderer)
     );
 
     /* Needle center pivot overlay. */
-    DrawCircleV(
+    draw_circle(
+        renderer,
         (Vector2){ local_params->center.x, local_params->center.y },
         MAX(local_params->needle_pivot_radius, 6.0f),
         local_params->needle_pivot_color
     );
 
-    EndTextureMode();
+    renderer->canvas_end(renderer);
+
+    /* The face never changes, so let the renderer compose it once if it can. */
+    self->draw_static = needle_meter__default__draw_static;
 
     return ERR_OK;
 }
@@ -200,10 +213,10 @@ static void
 needle_meter__default__update(widget_t *self)
 {
     // NOTE: Everything from here below MUST BE DRAWN RELATIVE TO THE SCREEN ORIGIN, not the texture origin.
-    struct draw_params *local_params = (struct draw_params *)(self->state.internal);
+    struct draw_params *local_params = (struct draw_params *)(self->state->internal);
 
     /* Draw needle (angle from center) */
-    float needle_value = (needle_data->value * local_params->needle_scale) - local_params->minimum_value;
+    float needle_value = (rtd_read(needle_data) * local_params->needle_scale) - local_params->minimum_value;
 
     float needle_angle = local_params->start_angle_ticks +
         ((needle_value / (local_params->maximum_value - local_params->minimum_value))
@@ -216,23 +229,32 @@ needle_meter__default__update(widget_t *self)
 
 
 static void
-needle_meter__default__draw(widget_t *self, const renderer_t *renderer)
+needle_meter__default__draw_static(widget_t *self, const renderer_t *renderer)
 {
-    struct draw_params *local_params = (struct draw_params *)(self->state.internal);
+    struct draw_params *local_params = (struct draw_params *)(self->state->internal);
 
-    /* Render static needle_meter background content from the preloaded texture. */
-    DrawTexturePro(
-        local_params->static_texture.texture,
-        (Rectangle){ 0, 0, MY_WIDTH, -MY_HEIGHT },
+    /* Render static needle_meter background content from the preloaded canvas. */
+    draw_canvas(
+        renderer,
+        local_params->static_canvas,
+        (Rectangle){ 0, 0, MY_WIDTH, MY_HEIGHT },
         (Rectangle){ MY_X, MY_Y, MY_WIDTH, MY_HEIGHT },
         (Vector2){ 0, 0 },
         MY_ANGLE,
         WHITE
     );
+}
+
 
-    DrawTexturePro(
-        local_params->needle_texture.texture,
-        (Rectangle){ 0, 0, MY_WIDTH, -MY_HEIGHT },
+static void
+needle_meter__default__draw(widget_t *self, const renderer_t *renderer)
+{
+    struct draw_params *local_params = (struct draw_params *)(self->state->internal);
+
+    draw_canvas(
+        renderer,
+        local_params->needle_canvas,
+        (Rectangle){ 0, 0, MY_WIDTH, MY_HEIGHT },
         (Rectangle){ MY_X + local_params->center.x, MY_Y + local_params->center.y, MY_WIDTH, MY_HEIGHT },
         (Vector2){ local_params->center.x, local_params->center.y },
         local_params->needle_degrees,
@@ -241,185 +263,70 @@ needle_meter__default__draw(widget_t *self, const renderer_t *renderer)
 }
 
 
+/* Sorted by key, for 'parse_widget_options'. */
+#define NEEDLE_OPTION(key, type)            WIDGET_OPTION(#key, type, struct draw_params, key)
+#define NEEDLE_OPTION_OR(key, type, ...)    WIDGET_OPTION_OR(#key, type, struct draw_params, key, __VA_ARGS__)
+
+static const widget_option_schema_t needle_meter__default__options[] =
+{
+    NEEDLE_OPTION(backdrop_color, OPTION_COLOR),
+    NEEDLE_OPTION(border_color, OPTION_COLOR),
+    NEEDLE_OPTION(end_angle, OPTION_FLOAT),
+    NEEDLE_OPTION(end_angle_ticks, OPTION_FLOAT),
+    NEEDLE_OPTION_OR(has_labels, OPTION_BOOL, .boolean = false),
+    NEEDLE_OPTION(inner_radius, OPTION_FLOAT),
+    NEEDLE_OPTION(interval, OPTION_FLOAT),
+    NEEDLE_OPTION(label_text_size, OPTION_INT),
+    NEEDLE_OPTION(maximum_value, OPTION_FLOAT),
+    NEEDLE_OPTION(minimum_value, OPTION_FLOAT),
+    NEEDLE_OPTION(needle_color, OPTION_COLOR),
+    NEEDLE_OPTION(needle_pivot_color, OPTION_COLOR),
+    NEEDLE_OPTION(needle_pivot_radius, OPTION_FLOAT),
+    NEEDLE_OPTION_OR(needle_scale, OPTION_FLOAT, .number = 1.0f),
+    NEEDLE_OPTION_OR(redline_fades_in, OPTION_BOOL, .boolean = false),
+    NEEDLE_OPTION(redline_start_value, OPTION_FLOAT),
+    NEEDLE_OPTION(segments, OPTION_INT),
+    NEEDLE_OPTION(start_angle, OPTION_FLOAT),
+    NEEDLE_OPTION(start_angle_ticks, OPTION_FLOAT),
+    NEEDLE_OPTION(sub_interval, OPTION_FLOAT),
+    NEEDLE_OPTION(sub_tick_thickness, OPTION_FLOAT),
+    NEEDLE_OPTION(text_color, OPTION_COLOR),
+    NEEDLE_OPTION(tick_color, OPTION_COLOR),
+    NEEDLE_OPTION(tick_thickness, OPTION_FLOAT),
+    NEEDLE_OPTION_OR(unit_text, OPTION_TEXT, .text = ""),
+    NEEDLE_OPTION(unit_text_position, OPTION_COORDS),
+    NEEDLE_OPTION(unit_text_size, OPTION_INT),
+};
+
+
 static ic_err_t
 needle_meter__default__parse_args(widget_t *self)
 {
-    char *option = NULL, *name = NULL;
-
-    self->state.internal = calloc(1, sizeof(struct draw_params));
-    if (NULL == self->state.internal) return ERR_OUT_OF_RESOURCES;
+    self->state->internal = widget_alloc(1, sizeof(struct draw_params));
+    if (NULL == self->state->internal) return ERR_OUT_OF_RESOURCES;
 
-    struct draw_params *local_params = (struct draw_params *)(self->state.internal);
+    struct draw_params *local_params = (struct draw_params *)(self->state->internal);
 
     local_params->center = (Vector2){
-        .x = self->state.resolution.x / 2,
-        .y = self->state.resolution.y / 2
+        .x = self->state->resolution.x / 2,
+        .y = self->state->resolution.y / 2
     };
 
     /* Fixed outer radius. */
-    local_params->outer_radius = MIN(self->state.resolution.x / 2, self->state.resolution.y / 2);
+    local_params->outer_radius = MIN(self->state->resolution.x / 2, self->state->resolution.y / 2);
+
+    ic_err_t status = parse_widget_options(
+        self,
+        needle_meter__default__options,
+        sizeof(needle_meter__default__options) / sizeof(widget_option_schema_t),
+        local_params
+    );
+    if (ERR_OK != status) return status;
 
-    OPTION_OR_DIE("inner_radius");
-    local_params->inner_radius = atof(option);
     if (local_params->inner_radius >= local_params->outer_radius) {
         fprintf(stderr, "FATAL:  needle_meter cannot have an inner_radius >= its outer_radius.\n");
         return ERR_ARGS;
     }
-    DPRINTLN("inner_radius(%f)", local_params->inner_radius);
-
-    OPTION_OR_DIE("needle_scale");
-    local_params->needle_scale = atof(option);
-    DPRINTLN("needle_scale(%f)", local_params->needle_scale);
-
-    OPTION_OR_DIE("segments");
-    local_params->segments = atoi(option);
-    DPRINTLN("segments(%u)", local_params->segments);
-
-    OPTION_OR_DIE("start_angle");
-    local_params->start_angle = atof(option);
-    DPRINTLN("start_angle(%f)", local_params->start_angle);
-
-    OPTION_OR_DIE("end_angle");
-    local_params->end_angle = atof(option);
-    DPRINTLN("end_angle(%f)", local_params->end_angle);
-
-    OPTION_OR_DIE("start_angle_ticks");
-    local_params->start_angle_ticks = atof(option);
-    DPRINTLN("start_angle_ticks(%f)", local_params->start_angle_ticks);
-
-    OPTION_OR_DIE("end_angle_ticks");
-    local_params->end_angle_ticks = atof(option);
-    DPRINTLN("end_angle_ticks(%f)", local_params->end_angle_ticks);
-
-    OPTION_OR_DIE("minimum_value");
-    local_params->minimum_value = atof(option);
-    DPRINTLN("minimum_value(%f)", local_params->minimum_value);
-
-    OPTION_OR_DIE("maximum_value");
-    local_params->maximum_value = atof(option);
-    DPRINTLN("maximum_value(%f)", local_params->maximum_value);
-
-    OPTION_OR_DIE("interval");
-    local_params->interval = atof(option);
-    DPRINTLN("interval(%f)", local_params->interval);
-
-    OPTION_OR_DIE("sub_interval");
-    local_params->sub_interval = atof(option);
-    DPRINTLN("sub_interval(%f)", local_params->sub_interval);
-
-    OPTION_OR_DIE("redline_start_value");
-    local_params->redline_start_value = atof(option);
-    DPRINTLN("redline_start_value(%f)", local_params->redline_start_value);
-
-    OPTION_OR_DIE("redline_fades_in");
-    local_params->redline_fades_in = (0 == strcmp(option, "True")) ? true : false;
-    DPRINTLN("redline_fades_in(%u)", local_params->redline_fades_in);
-
-    OPTION_OR_DIE("tick_thickness");
-    local_params->tick_thickness = atof(option);
-    DPRINTLN("tick_thickness(%f)", local_params->tick_thickness);
-
-    OPTION_OR_DIE("sub_tick_thickness");
-    local_params->sub_tick_thickness = atof(option);
-    DPRINTLN("sub_tick_thickness(%f)", local_params->sub_tick_thickness);
-
-    OPTION_OR_DIE("needle_pivot_radius");
-    local_params->needle_pivot_radius = atof(option);
-    DPRINTLN("needle_pivot_radius(%f)", local_params->needle_pivot_radius);
-
-    OPTION_OR_DIE("label_text_size");
-    local_params->label_text_size = atoi(option);
-    DPRINTLN("label_text_size(%u)", local_params->label_text_size);
-
-    OPTION_OR_DIE("has_labels");
-    local_params->has_labels = 0 == strcasecmp(option, "True");
-    DPRINTLN("has_labels(%u)", local_params->has_labels);
-
-    OPTION_OR_DIE("unit_text");
-    local_params->unit_text = option;
-    DPRINTLN("unit_text(%s)", local_params->unit_text);
-
-    OPTION_OR_DIE("unit_text_size");
-    local_params->unit_text_size = atoi(option);
-    DPRINTLN("unit_text_size(%u)", local_params->unit_text_size);
-
-    OPTION_OR_DIE("unit_text_position");
-    char *x = strtok(option, ":");
-    char *y = strtok(NULL, ":");
-    if (x[strlen(x)-1] == '%') {
-        x[strlen(x)-1] = '\0';
-        local_params->unit_text_position.x = (atof(x) / 100.0f) * MY_WIDTH;
-    } else local_params->unit_text_position.x = atoi(x);
-    if (y[strlen(y)-1] == '%') {
-        y[strlen(y)-1] = '\0';
-        local_params->unit_text_position.y = (atof(y) / 100.0f) * MY_HEIGHT;
-    } else local_params->unit_text_position.y = atof(y);
-    if (NULL == x || NULL == y) goto param_error;
-    DPRINTLN("unit_text_position(%u,%u)", local_params->unit_text_position.x, local_params->unit_text_position.y);
-
-    OPTION_OR_DIE("backdrop_color");
-    if (8 != strlen(option)) goto param_error;
-    option = strdup(option);
-    local_params->backdrop_color.a = hex_to_value(&option[6]); option[6] = '\0';
-    local_params->backdrop_color.b = hex_to_value(&option[4]); option[4] = '\0';
-    local_params->backdrop_color.g = hex_to_value(&option[2]); option[2] = '\0';
-    local_params->backdrop_color.r = hex_to_value(&option[0]);
-    free(option);
-    DPRINT("backdrop_color "); MEMDUMP(&local_params->backdrop_color, sizeof(Color));
-
-    OPTION_OR_DIE("border_color");
-    if (8 != strlen(option)) goto param_error;
-    option = strdup(option);
-    local_params->border_color.a = hex_to_value(&option[6]); option[6] = '\0';
-    local_params->border_color.b = hex_to_value(&option[4]); option[4] = '\0';
-    local_params->border_color.g = hex_to_value(&option[2]); option[2] = '\0';
-    local_params->border_color.r = hex_to_value(&option[0]);
-    free(option);
-    DPRINT("border_color "); MEMDUMP(&local_params->border_color, sizeof(Color));
-
-    OPTION_OR_DIE("tick_color");
-    if (8 != strlen(option)) goto param_error;
-    option = strdup(option);
-    local_params->tick_color.a = hex_to_value(&option[6]); option[6] = '\0';
-    local_params->tick_color.b = hex_to_value(&option[4]); option[4] = '\0';
-    local_params->tick_color.g = hex_to_value(&option[2]); option[2] = '\0';
-    local_params->tick_color.r = hex_to_value(&option[0]);
-    free(option);
-    DPRINT("tick_color "); MEMDUMP(&local_params->tick_color, sizeof(Color));
-
-    OPTION_OR_DIE("text_color");
-    if (8 != strlen(option)) goto param_error;
-    option = strdup(option);
-    local_params->text_color.a = hex_to_value(&option[6]); option[6] = '\0';
-    local_params->text_color.b = hex_to_value(&option[4]); option[4] = '\0';
-    local_params->text_color.g = hex_to_value(&option[2]); option[2] = '\0';
-    local_params->text_color.r = hex_to_value(&option[0]);
-    free(option);
-    DPRINT("text_color "); MEMDUMP(&local_params->text_color, sizeof(Color));
-
-    OPTION_OR_DIE("needle_color");
-    if (8 != strlen(option)) goto param_error;
-    option = strdup(option);
-    local_params->needle_color.a = hex_to_value(&option[6]); option[6] = '\0';
-    local_params->needle_color.b = hex_to_value(&option[4]); option[4] = '\0';
-    local_params->needle_color.g = hex_to_value(&option[2]); option[2] = '\0';
-    local_params->needle_color.r = hex_to_value(&option[0]);
-    free(option);
-    DPRINT("needle_color "); MEMDUMP(&local_params->needle_color, sizeof(Color));
-
-    OPTION_OR_DIE("needle_pivot_color");
-    if (8 != strlen(option)) goto param_error;
-    option = strdup(option);
-    local_params->needle_pivot_color.a = hex_to_value(&option[6]); option[6] = '\0';
-    local_params->needle_pivot_color.b = hex_to_value(&option[4]); option[4] = '\0';
-    local_params->needle_pivot_color.g = hex_to_value(&option[2]); option[2] = '\0';
-    local_params->needle_pivot_color.r = hex_to_value(&option[0]);
-    free(option);
-    DPRINT("needle_pivot_color "); MEMDUMP(&local_params->needle_pivot_color, sizeof(Color));
 
     return ERR_OK;
-
-param_error:
-    fprintf(stderr, "FATAL: Widget option/argument '%s' was not found or is not valid for its type.\n", name);
-    return ERR_ARGS;
 }
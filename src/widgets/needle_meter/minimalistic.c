@@ -9,19 +9,22 @@ static void
 needle_meter__minimalistic__update(widget_t *self)
 {
     // TODO: Testing. Remove.
+#if IC_DEBUG==1
     for (int i = 0; i < self->num_parent_signals; ++i) {
-        if (self->parent_signals[i]->real_time_data.has_update) {
+        if (rtd_has_update(&self->parent_signals[i]->real_time_data)) {
+            double value = rtd_read(&self->parent_signals[i]->real_time_data);
             DPRINTLN("[%s] SIGNAL RAW DATA (CHANNEL%u: %s): ", self->label, i, self->parent_signals[i]->name);
-            MEMDUMP(&(self->parent_signals[i]->real_time_data.value), 8);
+            MEMDUMP(&value, 8);
         }
     }
+#endif   /* IC_DEBUG */
 }
 
 
 static void
 needle_meter__minimalistic__draw(widget_t *self, const renderer_t *renderer)
 {
-    DrawEllipse(300, 300, 20, 80, RAYWHITE);
+    draw_ellipse(renderer, (Vector2){ 300, 300 }, 20, 80, RAYWHITE);
 }
 
 
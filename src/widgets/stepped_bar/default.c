@@ -4,19 +4,22 @@
 
 #include "widget_common.h"
 
-#include <raylib.h>
-
 
 static void
 stepped_bar__default__update(widget_t *self)
 {
     // TODO: Fix this once signal parsing works.
-    MY_X = x_pos->value;
-    MY_Y = y_pos->value;
-    MY_ANGLE = rotation->value;
+    MY_X = rtd_read(x_pos);
+    MY_Y = rtd_read(y_pos);
+    MY_ANGLE = rtd_read(rotation);
+
+    /* Drawn centered on its position and rotated about that center, so it stays within this circle. */
+    int32_t radius = (int32_t)ceil(hypot(MY_WIDTH, MY_HEIGHT) / 2.0);
+    self->state->bounds.position = (vec2_t){ MY_X - radius, MY_Y - radius };
+    self->state->bounds.resolution = (vec2_t){ 2 * radius, 2 * radius };
 
     // for (int i = 0; i < self->num_parent_signals; ++i) {
-    //     if (self->parent_signals[i]->real_time_data.has_update) {
+    //     if (rtd_has_update(&self->parent_signals[i]->real_time_data)) {
     //         DPRINTLN("[%s] SIGNAL RAW DATA (CHANNEL%u: %s): ", self->label, i, self->parent_signals[i]->name);
     //         MEMDUMP(&(self->parent_signals[i]->real_time_data.value), 8);
     //         DPRINTLN(">>>>> (%u, %u, %f deg)", MY_X, MY_Y, MY_ANGLE);
@@ -29,7 +32,8 @@ static void
 stepped_bar__default__draw(widget_t *self, const renderer_t *renderer)
 {
     // TODO: Just an example.
-    DrawRectanglePro(
+    draw_rect(
+        renderer,
         (Rectangle){ MY_X, MY_Y, MY_WIDTH, MY_HEIGHT },
         (Vector2){ (MY_WIDTH/2), (MY_HEIGHT/2) },
         MY_ANGLE,
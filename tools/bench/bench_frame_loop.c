@@ -0,0 +1,243 @@
+/*
+ * The per-frame widget bookkeeping of the renderers' loops, over many widgets: collecting dirty
+ *  widgets, the update scan, the dirty rectangle scan (with IC_OPT_PARTIAL_REDRAW) and consuming
+ *  signals. Widget hooks are not called and nothing is drawn, so what's timed is only how the loop
+ *  reaches each widget's state. The configured widgets are repeated up to the requested count, in a
+ *  shuffled z order, all shown on every page.
+ *
+ * Two layouts are timed. 'packed' walks 'widget_states' in z order, as the renderers do. 'pointers'
+ *  is the layout from before 'widget_states': whole widgets with their state inline, after the load
+ *  time configuration, created in load order and reached through a z-ordered list of pointers.
+ *
+ * Pass 'cold' to evict the caches before every frame, as a busy dashboard would between frames.
+ *  Count the misses of one layout with: perf stat -e cache-misses bench_frame_loop 256 cold packed
+ *
+ * Usage: bench_frame_loop [widgets] [warm|cold] [both|packed|pointers]
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "flex_ic.h"
+#include "renderer.h"
+#include "widget.h"
+
+
+/* There's no renderer or CAN thread here; only the window size is looked at, for widget bounds. */
+static renderer_t renderer;
+const renderer_t *global_renderer = &renderer;
+
+can_bus_meta_t CAN;
+
+#if IC_OPT_LATENCY_TRACKING==1
+_Thread_local uint64_t can_rx_time_ns;
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+
+#define NUM_FRAMES          2000
+#define EVICTION_SIZE       (32 << 20)   /* larger than any last-level cache it should run on */
+
+
+/* 'widget_t' as it was before 'widget_states', field for field. */
+typedef
+struct {
+    _func__widget_update        update;
+    _func__widget_draw          draw;
+    _func__widget_init          init;
+    _func__widget_draw          draw_static;
+    uint32_t index;
+    const char *label;
+    const char *type;
+    uint8_t page;
+    const widget_option_t *options;
+    uint32_t num_options;
+    const char *skin_name;
+    dbc_signal_t **parent_signals;
+    uint32_t num_parent_signals;
+    bool draw_outline;
+    widget_state_t state;
+} pointer_widget_t;
+
+
+static uint32_t num_widgets = 256;
+static bool cold = false;
+
+static bool *widget_is_dirty;
+static char *eviction;
+
+#if IC_OPT_PARTIAL_REDRAW==1
+static Rectangle *last_bounds;
+#endif   /* IC_OPT_PARTIAL_REDRAW */
+
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+
+/* One frame's bookkeeping. 'visible' is NULL for the packed layout, else the page's visible widgets by pointer. */
+static uint32_t
+bookkeep_frame(const widget_page_t *page, pointer_widget_t *const *visible)
+{
+    uint32_t sink = 0;
+
+    take_dirty_widgets(widget_is_dirty);
+    apply_visibility_signals(widget_is_dirty);
+
+    for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+        if (NULL == visible) {
+            uint32_t index = page->visible_widgets[i];
+            if (!widget_is_dirty[index] && !widget_states[index].animating) continue;
+
+            sink += global_widgets[index]->num_parent_signals;   /* stands in for 'update' */
+        } else {
+            const pointer_widget_t *widget = visible[i];
+            if (!widget_is_dirty[widget->index] && !widget->state.animating) continue;
+
+            sink += widget->num_parent_signals;
+        }
+    }
+
+#if IC_OPT_PARTIAL_REDRAW==1
+    for (uint32_t i = 0; i < page->num_visible_widgets; ++i) {
+        uint32_t index = (NULL == visible) ? page->visible_widgets[i] : visible[i]->index;
+        const widget_state_t *state = (NULL == visible) ? &widget_states[index] : &visible[i]->state;
+
+        Rectangle bounds = widget_screen_bounds(state, &renderer);
+        bool moved = 0 != memcmp(&bounds, &last_bounds[index], sizeof(Rectangle));
+
+        if (moved || widget_is_dirty[index] || state->animating) ++sink;
+
+        last_bounds[index] = bounds;
+    }
+#endif   /* IC_OPT_PARTIAL_REDRAW */
+
+    consume_widget_signals(page, widget_is_dirty);
+
+    return sink;
+}
+
+
+static void
+run(const char *layout, const widget_page_t *page, pointer_widget_t *const *visible)
+{
+    uint64_t elapsed_ns = 0;
+    volatile uint32_t sink = 0;
+
+    for (uint32_t frame = 0; frame < NUM_FRAMES; ++frame) {
+        if (cold) memset(eviction, (int)frame, EVICTION_SIZE);
+
+        uint64_t start_ns = now_ns();
+        sink += bookkeep_frame(page, visible);
+        elapsed_ns += now_ns() - start_ns;
+    }
+
+    printf(
+        "%" PRIu32 " widgets, %s caches, %-8s %6.2f us of bookkeeping per frame\n",
+        page->num_visible_widgets, cold ? "cold" : "warm", layout, (double)elapsed_ns / NUM_FRAMES / 1000.0
+    );
+}
+
+
+int
+main(int argc, char **argv)
+{
+    if (argc > 1) num_widgets = (uint32_t)strtoul(argv[1], NULL, 10);
+    cold = (argc > 2) && 0 == strcmp("cold", argv[2]);
+    const char *layouts = (argc > 3) ? argv[3] : "both";
+
+    bool run_packed = 0 == strcmp("both", layouts) || 0 == strcmp("packed", layouts);
+    bool run_pointers = 0 == strcmp("both", layouts) || 0 == strcmp("pointers", layouts);
+
+    if (0 == num_widgets || 0 == NUM_WIDGET_DESCRIPTORS || !(run_packed || run_pointers)) {
+        fprintf(stderr, "Usage: %s [widgets] [warm|cold] [both|packed|pointers]   (and a configuration with at least one widget)\n", argv[0]);
+        return 1;
+    }
+
+    renderer.resolution = compile_time_ic_options.window.dimensions;
+
+    widget_descriptor_t *descriptors = calloc(num_widgets, sizeof(widget_descriptor_t));
+    uint32_t *z_order = calloc(num_widgets, sizeof(uint32_t));
+    widget_is_dirty = calloc(num_widgets, sizeof(bool));
+    eviction = cold ? malloc(EVICTION_SIZE) : NULL;
+    if (NULL == descriptors || NULL == z_order || NULL == widget_is_dirty || (cold && NULL == eviction)) return 1;
+
+    /* Every z-index once, in an order unrelated to the load order; the same one for the same count every run. */
+    srand(num_widgets);
+    for (uint32_t i = 0; i < num_widgets; ++i) z_order[i] = i;
+    for (uint32_t i = num_widgets - 1; i > 0; --i) {
+        uint32_t j = (uint32_t)rand() % (i + 1);
+        uint32_t swap = z_order[i];
+        z_order[i] = z_order[j];
+        z_order[j] = swap;
+    }
+
+    for (uint32_t i = 0; i < num_widgets; ++i) {
+        descriptors[i] = WIDGET_DESCRIPTORS[i % NUM_WIDGET_DESCRIPTORS];
+        descriptors[i].z_index = z_order[i];
+        descriptors[i].page = WIDGET_PAGE_ALL;
+        descriptors[i].visible = true;
+        descriptors[i].visibility_signal_index = -1;
+    }
+
+    if (ERR_OK != load_widgets(descriptors, num_widgets)) return 1;
+
+    const widget_page_t *page = active_widget_page();
+
+    /*
+     * The old layout: one array of whole widgets in load order (as its arena laid them out), which
+     *  the page reached in z order by pointer. With unique z-indices, a widget's 'index' is its z-index.
+     */
+    pointer_widget_t *pointer_widgets = calloc(num_widgets, sizeof(pointer_widget_t));
+    pointer_widget_t **pointer_visible = calloc(num_widgets, sizeof(pointer_widget_t *));
+    pointer_widget_t **by_index = calloc(num_widgets, sizeof(pointer_widget_t *));
+    if (NULL == pointer_widgets || NULL == pointer_visible || NULL == by_index) return 1;
+
+    for (uint32_t i = 0; i < num_widgets; ++i) {
+        const widget_t *widget = global_widgets[z_order[i]];
+
+        pointer_widgets[i] = (pointer_widget_t){
+            .update = widget->update,
+            .draw = widget->draw,
+            .init = widget->init,
+            .draw_static = widget->draw_static,
+            .index = widget->index,
+            .label = widget->label,
+            .type = widget->type,
+            .page = widget->page,
+            .options = widget->options,
+            .num_options = widget->num_options,
+            .skin_name = widget->skin_name,
+            .parent_signals = widget->parent_signals,
+            .num_parent_signals = widget->num_parent_signals,
+            .draw_outline = widget->draw_outline,
+            .state = *widget->state,
+        };
+        by_index[widget->index] = &pointer_widgets[i];
+    }
+
+    for (uint32_t i = 0; i < page->num_visible_widgets; ++i)
+        pointer_visible[i] = by_index[page->visible_widgets[i]];
+
+#if IC_OPT_PARTIAL_REDRAW==1
+    last_bounds = calloc(num_global_widgets, sizeof(Rectangle));
+    if (NULL == last_bounds) return 1;
+#endif   /* IC_OPT_PARTIAL_REDRAW */
+
+    /* Loading marks every widget dirty; start from a settled dashboard. */
+    take_dirty_widgets(widget_is_dirty);
+    consume_widget_signals(page, widget_is_dirty);
+
+    if (run_pointers) run("pointers", page, pointer_visible);
+    if (run_packed) run("packed", page, NULL);
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * CAN ID resolution with whichever IC_OPT_ID_MAPPING the generated options select. This includes
+ *  the listener's own source so that the exact lookup 'process_can_frame' uses is what gets timed.
+ *  'id_mapping.sh' builds it once per strategy against synthetic DBCs of different sizes.
+ *
+ * Usage: bench_id_mapping [lookups]
+ */
+
+#include "canbus.c"
+
+#include <inttypes.h>
+#include <time.h>
+
+
+const ic_opts_t compile_time_ic_options;
+can_bus_meta_t CAN;
+
+void
+mark_signal_widgets_dirty(const dbc_signal_t *signal)
+{
+    (void)signal;
+}
+
+
+static const char *strategy_names[] = { "linear", "table", "sorted" };
+
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+
+/* The same resolution 'process_can_frame' does. */
+static inline const dbc_message_t *
+resolve(canid_t id)
+{
+    const dbc_message_t *message = NULL;
+
+#if IC_OPT_ID_MAPPING==1
+    if (ERR_OK != lookup_dbc_msg_by_id(id, &message)) return NULL;
+#elif IC_OPT_ID_MAPPING==2
+    message = lookup_sorted_dbc_msg_by_id(id);
+#else   /* IC_OPT_ID_MAPPING */
+    DBC_MSG_BY_ID(message, id);
+#endif   /* IC_OPT_ID_MAPPING */
+
+    return message;
+}
+
+
+int
+main(int argc, char **argv)
+{
+    uint32_t num_lookups = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 2000000;
+
+    if (0 == num_lookups || 0 == DBC_MESSAGES_LEN) {
+        fprintf(stderr, "Usage: %s [lookups]   (and a DBC with at least one message)\n", argv[0]);
+        return 1;
+    }
+
+#if IC_OPT_ID_MAPPING==1
+    if (ERR_OK != create_dbc_id_map()) return 1;
+#endif   /* IC_OPT_ID_MAPPING */
+
+    /* 4 in 5 frames are for a known message; the rest are IDs the DBC doesn't have (or mostly doesn't). */
+    canid_t *ids = malloc(sizeof(canid_t) * num_lookups);
+    if (NULL == ids) return 1;
+
+    srand(DBC_MESSAGES_LEN);
+    for (uint32_t i = 0; i < num_lookups; ++i)
+        ids[i] = (rand() % 5) ? DBC.messages[rand() % DBC_MESSAGES_LEN].id : (canid_t)(rand() & 0x7FF);
+
+    uint32_t found = 0;
+    uint64_t start_ns = now_ns();
+
+    for (uint32_t i = 0; i < num_lookups; ++i)
+        found += (NULL != resolve(ids[i]));
+
+    uint64_t elapsed_ns = now_ns() - start_ns;
+
+    printf(
+        "%5d messages, %-6s %8.1f ns per lookup (%.1f%% found)\n",
+        DBC_MESSAGES_LEN, strategy_names[IC_OPT_ID_MAPPING],
+        (double)elapsed_ns / (double)num_lookups, 100.0 * found / num_lookups
+    );
+
+    free(ids);
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * Signal publication under contention: the per-signal mutexes FlexIC used to take against the
+ *  seqlock in 'real_time_data_t'. A publisher thread floods values into every signal, as the CAN
+ *  thread does under a burst of frames, while a reader thread reads and consumes them back-to-back,
+ *  as an unthrottled render loop would.
+ *
+ * Usage: bench_rtd [signals] [publishes]
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "flex_ic.h"
+
+
+#if IC_OPT_LATENCY_TRACKING==1
+_Thread_local uint64_t can_rx_time_ns;
+#endif   /* IC_OPT_LATENCY_TRACKING */
+
+can_bus_meta_t CAN;
+
+
+/* How signal values were published before the seqlock. */
+typedef
+struct {
+    volatile bool has_update;
+    volatile double value;
+    pthread_mutex_t lock;
+} mutex_rtd_t;
+
+static struct {
+    volatile bool has_update;
+    pthread_mutex_t lock;
+} mutex_can = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+
+static uint32_t num_signals = 64;
+static uint64_t num_publishes = 5000000;
+
+static mutex_rtd_t *mutex_signals;
+static real_time_data_t *seqlock_signals;
+
+static atomic_bool stop_reading;
+
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+
+/* The old CAN thread: lock each signal to write it, then lock the global flag. */
+static void
+mutex_publish(mutex_rtd_t *rtd, double value)
+{
+    pthread_mutex_lock(&rtd->lock);
+    rtd->value = value;
+    rtd->has_update = true;
+    pthread_mutex_unlock(&rtd->lock);
+
+    pthread_mutex_lock(&mutex_can.lock);
+    mutex_can.has_update = true;
+    pthread_mutex_unlock(&mutex_can.lock);
+}
+
+
+/* The old render thread: read every value, then lock each updated signal (and the global flag) to clear it. */
+static void *
+mutex_reader(void *context)
+{
+    uint64_t *passes = (uint64_t *)context;
+    volatile double sink = 0.0;
+
+    while (!atomic_load_explicit(&stop_reading, memory_order_relaxed)) {
+        for (uint32_t i = 0; i < num_signals; ++i) sink += mutex_signals[i].value;
+
+        if (mutex_can.has_update) {
+            for (uint32_t i = 0; i < num_signals; ++i) {
+                if (!mutex_signals[i].has_update) continue;
+
+                pthread_mutex_lock(&mutex_signals[i].lock);
+                mutex_signals[i].has_update = false;
+                pthread_mutex_unlock(&mutex_signals[i].lock);
+            }
+
+            pthread_mutex_lock(&mutex_can.lock);
+            mutex_can.has_update = false;
+            pthread_mutex_unlock(&mutex_can.lock);
+        }
+
+        ++(*passes);
+    }
+
+    return NULL;
+}
+
+
+/* The render thread as it is now; see the end of each renderer's loop. */
+static void *
+seqlock_reader(void *context)
+{
+    uint64_t *passes = (uint64_t *)context;
+    volatile double sink = 0.0;
+
+    while (!atomic_load_explicit(&stop_reading, memory_order_relaxed)) {
+        for (uint32_t i = 0; i < num_signals; ++i) sink += rtd_read(&seqlock_signals[i]);
+
+        if (atomic_exchange_explicit(&CAN.has_update, false, memory_order_acq_rel)) {
+            for (uint32_t i = 0; i < num_signals; ++i)
+                rtd_consume(&seqlock_signals[i]);
+        }
+
+        ++(*passes);
+    }
+
+    return NULL;
+}
+
+
+static void
+run(const char *name, bool use_seqlock)
+{
+    pthread_t reader;
+    uint64_t passes = 0;
+
+    atomic_store(&stop_reading, false);
+    pthread_create(&reader, NULL, use_seqlock ? seqlock_reader : mutex_reader, &passes);
+
+    uint64_t start_ns = now_ns();
+
+    for (uint64_t n = 0; n < num_publishes; ++n) {
+        /* Always a new value: unchanged ones are skipped by 'rtd_publish' and would flatter the seqlock. */
+        if (use_seqlock) {
+            rtd_publish(&seqlock_signals[n % num_signals], (double)n);
+            atomic_store_explicit(&CAN.has_update, true, memory_order_release);
+        } else {
+            mutex_publish(&mutex_signals[n % num_signals], (double)n);
+        }
+    }
+
+    uint64_t elapsed_ns = now_ns() - start_ns;
+
+    atomic_store(&stop_reading, true);
+    pthread_join(reader, NULL);
+
+    printf(
+        "%-8s %8.1f ns per publish, %10.0f reader passes per second\n",
+        name, (double)elapsed_ns / (double)num_publishes, (double)passes * 1e9 / (double)elapsed_ns
+    );
+}
+
+
+int
+main(int argc, char **argv)
+{
+    if (argc > 1) num_signals = (uint32_t)strtoul(argv[1], NULL, 10);
+    if (argc > 2) num_publishes = strtoull(argv[2], NULL, 10);
+
+    if (0 == num_signals || 0 == num_publishes) {
+        fprintf(stderr, "Usage: %s [signals] [publishes]\n", argv[0]);
+        return 1;
+    }
+
+    mutex_signals = calloc(num_signals, sizeof(mutex_rtd_t));
+    seqlock_signals = calloc(num_signals, sizeof(real_time_data_t));
+    if (NULL == mutex_signals || NULL == seqlock_signals) return 1;
+
+    for (uint32_t i = 0; i < num_signals; ++i)
+        pthread_mutex_init(&mutex_signals[i].lock, NULL);
+
+    printf("%" PRIu32 " signals, %" PRIu64 " publishes, one reader spinning.\n", num_signals, num_publishes);
+
+    run("mutex", false);
+    run("seqlock", true);
+
+    return 0;
+}
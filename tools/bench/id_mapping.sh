@@ -0,0 +1,56 @@
+#!/bin/sh
+#
+# Compares the three IC_OPT_ID_MAPPING strategies on synthetic DBCs of 50, 500 and 5000 messages.
+#  Each DBC goes through fast_dbc_to_c, then 'bench_id_mapping.c' is built and run once per strategy.
+#  Run it from the repository root; 'make bench-ids' does. CC, CFLAGS and BENCH_DIR are honoured.
+
+BENCH_DIR="${BENCH_DIR:-build/bench}"
+CC="${CC:-clang}"
+CFLAGS="${CFLAGS:--O2}"
+WIDGETS_CONFIG="${WIDGETS_CONFIG:-examples/example_widgets.json}"
+
+
+err_msg()
+{
+  echo "ERROR: ${1}."
+  echo
+  exit ${2:-1}
+}
+
+
+[ -x tools/bench/synth_dbc.py ] || err_msg "Run this from the root of the FlexIC repository"
+
+for messages in 50 500 5000; do
+  gen_dir="${BENCH_DIR}/ids_${messages}"
+  mkdir -p "${gen_dir}" || err_msg "Could not create '${gen_dir}'"
+  gen_dir="$(cd "${gen_dir}" && pwd)"   # cargo runs from its own directory
+
+  ./tools/bench/synth_dbc.py ${messages} >"${gen_dir}/bench.dbc" || err_msg "Could not write a ${messages}-message DBC"
+
+  ( cd tools/fast_dbc_to_c && cargo run -q "${gen_dir}/bench.dbc" "${gen_dir}" yes ) >/dev/null \
+    || err_msg "Failed to run cargo generation for ${messages} messages"
+
+  for strategy in linear table sorted; do
+    opts_dir="${gen_dir}/${strategy}"
+    mkdir -p "${opts_dir}" || err_msg "Could not create '${opts_dir}'"
+
+    # Only the generated options header is used, so any configuration will do once 'id_lookup' is set.
+    python3 - "${WIDGETS_CONFIG}" "${strategy}" >"${opts_dir}/config.json" <<'EOF'
+import json, sys
+conf = json.load(open(sys.argv[1]))
+conf['can']['id_lookup'] = sys.argv[2]
+conf['window']['background']['type'] = 'COLOR'
+print(json.dumps(conf, indent=4))
+EOF
+    [ $? -eq 0 ] || err_msg "Could not write a '${strategy}' configuration"
+
+    ./tools/config_src_gen.py "${opts_dir}/config.json" "${opts_dir}" >/dev/null \
+      || err_msg "Failed to run the config source generator for '${strategy}'"
+
+    ${CC} ${CFLAGS} -DIC_DEBUG=0 -Isrc -Isrc/include -I"${opts_dir}" -I"${gen_dir}" \
+      -o "${opts_dir}/bench_id_mapping" tools/bench/bench_id_mapping.c "${gen_dir}/vehicle.c" -lpthread -lm \
+      || err_msg "Failed to build the '${strategy}' benchmark"
+
+    "${opts_dir}/bench_id_mapping" || err_msg "The '${strategy}' benchmark failed"
+  done
+done
@@ -0,0 +1,35 @@
+#!/usr/bin/env python3
+import random
+import sys
+
+
+# Writes a synthetic DBC with N messages of one 16-bit signal each, for the CAN ID lookup benchmark.
+#  IDs are 75% 11-bit and 25% 29-bit, like a typical vehicle, and are the same for the same N every run.
+
+if len(sys.argv) < 2:
+    sys.exit(f"USAGE: {sys.argv[0]} {{num-messages}}")
+
+num_messages = int(sys.argv[1])
+rng = random.Random(num_messages)
+standard_ids = set()
+extended_ids = set()
+
+while len(standard_ids) + len(extended_ids) < num_messages:
+    # There are only 2048 11-bit IDs; past that (or on a 1 in 4 roll), take a 29-bit one.
+    if rng.random() < 0.75 and len(standard_ids) < 0x800:
+        standard_ids.add(rng.randrange(0x800))
+    else:
+        extended_ids.add(rng.randrange(0x800, 0x20000000))
+
+# Declared in no particular order, as they would be in a real DBC.
+ids = sorted(standard_ids) + sorted(extended_ids)
+rng.shuffle(ids)
+
+print('VERSION "bench"\n\nNS_ :\n\nBS_:\n\nBU_: BENCH\n')
+
+for index, message_id in enumerate(ids):
+    # Extended IDs are written with bit 31 set.
+    dbc_id = message_id if message_id < 0x800 else (message_id | 0x80000000)
+
+    print(f"BO_ {dbc_id} Bench_{index}: 8 BENCH")
+    print(f"    SG_ Value_{index} : 0|16@1+ (1,0) [0|65535] \"\" BENCH\n")
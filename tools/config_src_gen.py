@@ -1,4 +1,6 @@
 #!/usr/bin/env python3
+import math
+import re
 import sys
 import json
 
@@ -79,6 +81,72 @@ with (open(out_opts, 'w') as out_h):
 
     bg = window['background'][bg_type.lower()]
 
+    # Widget pages are a uint8_t, and page 255 (WIDGET_PAGE_ALL) means "on every page".
+    if not 1 <= int(window['pages']) <= 255:
+        print(f"ERROR: Window 'pages' must be between 1 and 255 - got {window['pages']}.")
+        sys.exit(2)
+
+    can_batch = conf_dict['can'].get('batch_receive', {})
+    can_batch_depth = int(can_batch.get('depth', 16))
+    can_batch_timeout_us = int(can_batch.get('timeout_us', 1000))
+
+    # An empty batch makes 'recvmmsg' return at once, and a zero SO_RCVTIMEO blocks forever instead of timing out.
+    if can_batch_depth < 1 or can_batch_timeout_us < 1:
+        print(f"ERROR: CAN 'batch_receive' depth and timeout_us must be at least 1 - got {can_batch_depth} and {can_batch_timeout_us}.")
+        sys.exit(2)
+
+    idle_render = window.get('idle_render', {})
+
+    headless = window.get('headless', {})
+
+    profiler = conf_dict['debug'].get('profiler', {})
+
+    can_ring = conf_dict['can'].get('ingest_ring', {})
+    can_ring_depth = int(can_ring.get('depth', 256))
+
+    if can_ring_depth <= 0 or (can_ring_depth & (can_ring_depth - 1)) != 0:
+        print(f"ERROR: CAN 'ingest_ring' depth must be a power of two - got {can_ring_depth}.")
+        sys.exit(2)
+
+    max_id_filters = int(conf_dict['can'].get('max_id_filters', 16))
+
+    # Merging filters always leaves at least one, so the merge can't get below that.
+    if max_id_filters < 1:
+        print(f"ERROR: CAN 'max_id_filters' must be at least 1 - got {max_id_filters}.")
+        sys.exit(2)
+
+    # A single 'interface_name' is shorthand for one bus carrying every DBC message.
+    can_buses = conf_dict['can'].get('interfaces', [{'name': conf_dict['can'].get('interface_name')}])
+
+    if not can_buses or not all(bus.get('name') for bus in can_buses):
+        print("ERROR: CAN 'interfaces' must be a non-empty list, and each entry needs a 'name'.")
+        sys.exit(2)
+
+    if len([bus for bus in can_buses if not bus.get('messages')]) > 1:
+        print("ERROR: At most one CAN interface may omit its 'messages' list.")
+        sys.exit(2)
+
+    claimed_messages = [name for bus in can_buses for name in bus.get('messages', [])]
+    if len(claimed_messages) != len(set(claimed_messages)):
+        print("ERROR: Each DBC message may only be listed under one CAN interface.")
+        sys.exit(2)
+
+    can_buses_opts = "\n".join([
+        f"""            {{ .interface_name = "{bus['name']}", .message_names = """
+        + (f"""(const char *[]) {{ {", ".join([f'"{m}"' for m in bus['messages']])}, NULL }} }},"""
+            if bus.get('messages') else "NULL },")
+        for bus in can_buses
+    ])
+
+    id_lookup_strategies = {'linear': 0, 'table': 1, 'sorted': 2}
+    id_lookup = conf_dict['can'].get(
+        'id_lookup', 'table' if conf_dict['can'].get('use_fast_id_mapping', False) else 'linear'
+    ).lower()
+
+    if id_lookup not in id_lookup_strategies:
+        print(f"ERROR: CAN 'id_lookup' must be one of {list(id_lookup_strategies.keys())} - got {id_lookup}.")
+        sys.exit(2)
+
     if not bg_type.lower() == 'asset' or not bg['path']:
         raw_bg_asset = ""
     else:
@@ -120,12 +188,16 @@ f"""
 /* Types and constants. */
 
 /*
- * Enables O(1) [fast] lookup of message IDs, but requires much higher RAM consumption.
- *  This option should be set to 0 for systems with reduced RAM where there is a wide
- *  spread of CAN message ID values. When message ID values are highly localized, the
- *  memory consumption difference is negligible.
+ * Selects how received message IDs are resolved to DBC messages:
+ *   0 - Linear scan over all DBC messages. Smallest footprint, O(N) per frame.
+ *   1 - Enables O(1) [fast] lookup of message IDs, but requires much higher RAM consumption.
+ *        This option should not be used on systems with reduced RAM where there is a wide
+ *        spread of CAN message ID values. When message ID values are highly localized, the
+ *        memory consumption difference is negligible.
+ *   2 - Branchless binary search over a sorted ID array generated with the DBC. Memory is
+ *        proportional to the message count and lookups are O(log N) with no pointer chasing.
  */
-#define IC_OPT_ID_MAPPING               {0 if not conf_dict['can']['use_fast_id_mapping'] else 1}
+#define IC_OPT_ID_MAPPING               {id_lookup_strategies[id_lookup]}
 
 /* If set, disables render-time logging, even when IC_DEBUG is on. */
 #define IC_OPT_DISABLE_RENDER_TIME      {0 if not conf_dict['debug']['disable_render_time_reporting'] else 1}
@@ -133,13 +205,82 @@ f"""
 /* If set, disables received CAN message logging, even when IC_DEBUG is on. */
 #define IC_OPT_DISABLE_CAN_DETAILS      {0 if not conf_dict['debug']['disable_can_message_details'] else 1}
 
+/*
+ * Compose the dashboard in a persistent framebuffer and only repaint the areas of widgets which
+ *  changed (plus anything overlapping them) each frame, instead of redrawing the whole window.
+ */
+#define IC_OPT_PARTIAL_REDRAW           {0 if not window.get('partial_redraw', False) else 1}
+
+/*
+ * Bake the background and every widget's static face into one screen-sized texture at start-up,
+ *  so each frame begins with a single blit. Static faces then sit beneath all changing content,
+ *  regardless of z order. The layer is rebuilt whenever a widget's visibility changes.
+ */
+#define IC_OPT_STATIC_LAYER             {0 if not window.get('static_layer', False) else 1}
+
+/*
+ * Only render a frame when a signal changed, a widget is animating, or the last frame is older
+ *  than 'max_staleness_ms'. Otherwise the render thread sleeps until the CAN thread wakes it.
+ */
+#define IC_OPT_IDLE_RENDER              {0 if not idle_render.get('enabled', False) else 1}
+
+/*
+ * Track frame-to-photon latency: every received frame is stamped by the kernel, the stamp travels
+ *  with each decoded signal value, and the renderer records how long ago that frame arrived when a
+ *  widget showing the value is presented. A p50/p99/max summary is printed about once per second.
+ */
+#define IC_OPT_LATENCY_TRACKING         {0 if not conf_dict['debug'].get('track_latency', False) else 1}
+
+/*
+ * Compile in the per-widget profiler: 'update' and 'draw' times of every widget plus frame totals,
+ *  on a monotonic clock, summarized as min/avg/p99 every period. It works without IC_DEBUG, but stays
+ *  off until turned on at run time: FLEXIC_PROFILE=1 (stats) or =overlay (stats and on-screen
+ *  overlay) in the environment, SIGUSR1 to toggle it, and F3 to toggle the overlay in a window.
+ */
+#define IC_OPT_PROFILER                 {0 if not profiler.get('enabled', False) else 1}
+#define IC_OPT_PROFILER_PERIOD_MS       {int(profiler.get('period_ms', 1000))}
+
 /*
  * Whether to enable support for CAN FD or Extended (64-byte) data packets.
  *  Note that CAN buses which aren't sending frames with data over 8 bytes in
- *  length will be WASTING RAM if this option is enabled.
+ *  length will be WASTING RAM if this option is enabled. When set, the listener
+ *  turns on CAN_RAW_FD_FRAMES and accepts both CAN_MTU and CANFD_MTU reads;
+ *  otherwise only classic frames are read and longer DBC messages are dropped.
  */
 #define IC_OPT_CAN_FD_EXTENDED          {0 if not conf_dict['can']['enable_can_fd'] else 1}
 
+/*
+ * The number of CAN interfaces. Each one gets its own listener thread and socket, so a busy bus
+ *  can only ever back up its own receive queue. Every DBC message is decoded from one bus only.
+ */
+#define IC_OPT_CAN_NUM_BUSES            {len(can_buses)}
+
+/*
+ * Receive CAN frames in batches with a single 'recvmmsg' syscall instead of one 'read' per frame.
+ *  The batch depth is the maximum number of queued frames pulled from the socket per call. A call
+ *  never waits for a batch to fill: it returns as soon as at least one frame is available. The
+ *  timeout (see 'batch_timeout_us') bounds how long an idle socket blocks before the listener
+ *  wakes up to check whether it should close.
+ */
+#define IC_OPT_CAN_BATCH_RECV           {0 if not can_batch.get('enabled', False) else 1}
+#define IC_OPT_CAN_BATCH_DEPTH          {can_batch_depth}
+
+/*
+ * Split each bus listener into a socket reader and a decoder thread, joined by a lock-free
+ *  single-producer/single-consumer ring of raw frames. The reader does nothing but drain the socket,
+ *  so a decode stall backs up the ring (depth must be a power of two) instead of the kernel buffer.
+ */
+#define IC_OPT_CAN_INGEST_RING          {0 if not can_ring.get('enabled', False) else 1}
+#define IC_OPT_CAN_RING_DEPTH           {can_ring_depth}
+
+/*
+ * Install a kernel-side CAN_RAW_FILTER on the listener socket so only frames carrying signals that
+ *  are bound to widgets ever reach userspace. When more message IDs are referenced than the maximum
+ *  filter count, neighbouring IDs are merged into shared masks (which may admit a few extra IDs).
+ */
+#define IC_OPT_CAN_ID_FILTER            {0 if not conf_dict['can'].get('use_kernel_id_filter', False) else 1}
+#define IC_OPT_CAN_MAX_ID_FILTERS       {max_id_filters}
+
 /*
  * No standard library. You should use this if the platform you're running on isn't running
  *  a basic Linux version. BEWARE: you will have to implement all STDLIB calls yourself and
@@ -156,6 +297,10 @@ f"""
 /* Global configuration details. */
 extern const ic_opts_t compile_time_ic_options;
 
+/* Every configured widget, resolved at build time (see the generated 'config.c'). */
+extern const widget_descriptor_t WIDGET_DESCRIPTORS[];
+extern const uint32_t NUM_WIDGET_DESCRIPTORS;
+
 
 
 /********************************************************************/
@@ -174,13 +319,25 @@ const ic_opts_t compile_time_ic_options =
             .y = {window['dimensions']['height']}
         }},
         .full_screen = {"true" if window['full_screen'] else "false"},
-        .title = "{window['title']}"
+        .title = "{window['title']}",
+        .max_staleness_ms = {int(idle_render.get('max_staleness_ms', 1000))},
+        .headless = {{
+            .frames = {int(headless.get('frames', 0))},
+            .dump_every = {int(headless.get('dump_every', 0))},
+            .dump_path = "{headless.get('dump_path', '.')}"
+        }}
     }},
     .splash_hook_func = {window['splash_hook_func'] or "NULL"},
     .num_pages = {window['pages']},
+    .default_page_number = {int(window.get('default_page', 0))},
+    .page_signal_name = {f'"{window["page_signal"]}"' if window.get('page_signal') else "NULL"},
     .can = {{
-        .interface_name = "{conf_dict['can']['interface_name']}",
-        .enable_fd = {"true" if conf_dict['can']['enable_can_fd'] else "false"}
+        .buses = (const ic_can_bus_opts_t[]) {{
+{can_buses_opts}
+        }},
+        .num_buses = {len(can_buses)},
+        .enable_fd = {"true" if conf_dict['can']['enable_can_fd'] else "false"},
+        .batch_timeout_us = {can_batch_timeout_us}
     }},
     .background_type = {bg_type},
     .background_{bg_type.lower()} = {{
@@ -198,31 +355,113 @@ const ic_opts_t compile_time_ic_options =
 """
     )
 
-with open(out_conf, 'w') as out_c:
-    print("[truncated out-file]")
-    out_c.write(gen_stub)
-    out_c.write("const char *WIDGETS_CONFIGURATION =\n")
+def c_string(value):
+    return json.dumps(str(value))
+
+
+def c_bool(value):
+    return "true" if value else "false"
+
+
+def signal_index(name):
+    # Resolved by the compiler against the DBC's generated signal indices: a typo fails the build.
+    return f"DBC_SIGNAL_{name}"
+
+
+def as_number(text):
+    try:
+        number = float(text)
+    except ValueError:
+        return None
+
+    return number if math.isfinite(number) else None
+
+
+def option_initializer(key, value):
+    # JSON booleans keep the spelling the widget options have always had.
+    text = str(value)
+    fields = [f".key = {c_string(key)}", f".text = {c_string(text)}"]
+
+    number = None if isinstance(value, bool) else as_number(text)
+    if number is not None:
+        fields += [f".number = {number!r}", ".is_number = true"]
 
-# Generate the program-specific widgets config string.
-for widget in conf_dict['widgets']:
-    can_signal_names = ":".join(widget['can_signal_names'])
-    widget_label = widget['label']
-    type_and_skin = f"{widget['type']}:{(widget['skin'] or 'default')}"
-    visible = "yes" if widget['visible'] else "no"
-    orientation = f"{widget['position']['x']},{widget['position']['y']},{widget['dimensions']['width']},{widget['dimensions']['height']},{widget['rotation']}"
-    draw_outline = "yes" if widget['draw_boundary_outline'] else "no"
+    if re.fullmatch(r'[0-9a-fA-F]{8}', text):
+        fields += [f".color = {rgba_to_struct(text.lower())}", ".is_color = true"]
 
-    opts_str = (";".join([f"{key}={widget['options'][key]}" for key in widget['options'].keys()]) or "EMPTY") + ";"
+    coords = [(as_number(c.removesuffix('%')), c.endswith('%')) for c in text.split(':')]
+    if len(coords) == 2 and None not in (coords[0][0], coords[1][0]):
+        (x, x_percent), (y, y_percent) = coords
+        fields += [f".x = {{ {x!r}, {c_bool(x_percent)} }}", f".y = {{ {y!r}, {c_bool(y_percent)} }}", ".is_coords = true"]
 
-    with open(out_conf, 'a') as out_c:
-        out_c.write(
-            f"    \"{can_signal_names},{widget_label},{type_and_skin},{visible},{orientation},{widget['z_index']},{draw_outline},"
-            + f"{opts_str}\\n\"\n"
-        )
+    if text.lower() in ('true', 'yes'):
+        fields.append(".boolean = true")
 
+    return "{ " + ", ".join(fields) + " }"
+
+
+if not conf_dict['widgets']:
+    print("ERROR: No widgets are configured. FlexIC is useless without widgets.")
+    sys.exit(2)
+
+# Generate the program-specific widget descriptors. Everything is resolved here, so loading widgets parses nothing.
+widget_arrays = ""
+widget_descriptors = ""
+
+for index, widget in enumerate(conf_dict['widgets']):
+    page = widget.get('page')
+    if page is not None and not 0 <= int(page) < max(1, int(window['pages'])):
+        print(f"ERROR: Widget '{widget['label']}' is on page {page}, which is not one of the configured pages.")
+        sys.exit(2)
+
+    if not widget['can_signal_names']:
+        print(f"ERROR: Widget '{widget['label']}' has no CAN signals.")
+        sys.exit(2)
+
+    # Sorted by key (code point order, which is strcmp order on UTF-8), for the one-pass merge in 'parse_widget_options'.
+    options = sorted((key, value) for key, value in widget['options'].items() if value is not None)
+
+    widget_arrays += f"""
+static const uint16_t widget_{index}_signals[] = {{ {", ".join(signal_index(name) for name in widget['can_signal_names'])} }};
+"""
+    if options:
+        option_lines = "".join(f"    {option_initializer(key, value)},\n" for key, value in options)
+        widget_arrays += f"""static const widget_option_t widget_{index}_options[] =
+{{
+{option_lines}}};
+"""
+
+    widget_descriptors += f"""    {{
+        .label = {c_string(widget['label'])},
+        .type = {c_string(widget['type'])},
+        .skin_name = {c_string(widget['skin'] or 'default')},
+        .signal_indices = widget_{index}_signals,
+        .num_signals = {len(widget['can_signal_names'])},
+        .visibility_signal_index = {signal_index(widget['visibility_signal']) if widget.get('visibility_signal') else -1},
+        .position = {{ {int(widget['position']['x'])}, {int(widget['position']['y'])} }},
+        .resolution = {{ {int(widget['dimensions']['width'])}, {int(widget['dimensions']['height'])} }},
+        .rotation = {float(widget['rotation'])!r}f,
+        .z_index = {int(widget['z_index'])},
+        .page = {"UINT8_MAX" if page is None else int(page)},
+        .visible = {c_bool(widget['visible'])},
+        .draw_outline = {c_bool(widget['draw_boundary_outline'])},
+        .options = {f"widget_{index}_options" if options else "NULL"},
+        .num_options = {len(options)}
+    }},
+"""
+
+with open(out_conf, 'w') as out_c:
+    out_c.write(gen_stub)
+    out_c.write(f"""#include "flex_ic.h"
+
+{widget_arrays}
+
+const widget_descriptor_t WIDGET_DESCRIPTORS[] =
+{{
+{widget_descriptors}}};
 
-with open(out_conf, 'a') as out_c:
-    out_c.write(";")
+const uint32_t NUM_WIDGET_DESCRIPTORS = {len(conf_dict['widgets'])};
+""")
 
 with open(out_stub, 'w') as out_s:
     out_s.write(gen_stub)
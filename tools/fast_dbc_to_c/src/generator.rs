@@ -1,3 +1,4 @@
+use std::collections::BTreeMap;
 use std::io::{Error, Write};
 use std::fs::File;
 use std::process::Command;
@@ -58,6 +59,16 @@ fn name_filter(c: char) -> char {
 }
 
 
+/* The '<Message>_<Signal>' name a signal goes by in 'DBC.signals', the DBC_SIGNAL_* enum and the sorted name index. */
+fn signal_full_name(message: &Message, signal: &Signal) -> String {
+    format!(
+        "{}_{}",
+        message.message_name().chars().map(name_filter).collect::<String>(),
+        signal.name().chars().map(name_filter).collect::<String>()
+    )
+}
+
+
 pub fn generate_from_dbc(into_dir: &str, dbc: &DBC) -> Result<(), Error>
 {
     dbg!(&dbc);
@@ -138,6 +149,27 @@ fn generate_header(hdr_file: &mut File, dbc: &DBC) -> Result<(), Error>
         ).as_bytes()
     )?;
 
+    // Name every signal's index into 'DBC.signals' (same order and naming as 'gen_src_dbc_structs'),
+    //  so generated configuration sources refer to signals without any lookup at run time.
+    //  Widget descriptors hold these as uint16_t.
+    if dbc.signals().len() > u16::MAX as usize {
+        return Err(Error::other("Too many DBC signals to index (max 65535)."));
+    }
+
+    let mut signal_indices = String::new();
+    let mut signal_at = 0;
+
+    for message in dbc.messages().iter() {
+        for signal in message.signals().iter() {
+            signal_indices.push_str(&format!("    DBC_SIGNAL_{} = {},\n", signal_full_name(message, signal), signal_at));
+            signal_at += 1;
+        }
+    }
+
+    if signal_at > 0 {
+        hdr_file.write_all(format!("enum {{\n{}}};\n\n", signal_indices).as_bytes())?;
+    }
+
     hdr_file.write_all("\n\n\n#endif   /* GEN_IC_VEHICLE_H */\n".as_bytes())?;
     Ok(())
 }
@@ -146,7 +178,7 @@ fn generate_header(hdr_file: &mut File, dbc: &DBC) -> Result<(), Error>
 fn generate_source(src_file: &mut File, dbc: &DBC) -> Result<(), Error>
 {
     // Can't forget to include the generated header file.
-    src_file.write_all("#include \"vehicle.h\"\n#include \"flex_ic.h\"\n\n#include <pthread.h>\n\n".as_bytes())?;
+    src_file.write_all("#include \"vehicle.h\"\n#include \"flex_ic.h\"\n\n".as_bytes())?;
 
     // First thing's first: look for special comments that give the application special info.
     //  See the list of 'extern' properties in 'flex_ic.h' to link the two items together.
@@ -158,6 +190,9 @@ fn generate_source(src_file: &mut File, dbc: &DBC) -> Result<(), Error>
     }
 
     let struct_bodies = gen_src_dbc_structs(&dbc)?;
+    let decode_funcs = gen_src_decode_funcs(&dbc)?;
+    let sorted_ids = gen_src_sorted_message_ids(&dbc)?;
+    let sorted_names = gen_src_sorted_signal_names(&dbc)?;
 
     src_file.write_all(
         &format!(
@@ -171,11 +206,29 @@ dbc_signal_t signals[DBC_SIGNALS_LEN] =
 {}
 }};
 
+{}
 const dbc_message_t messages[DBC_MESSAGES_LEN] =
 {{
 {}
 }};
 
+/* Ascending message IDs and their index into 'messages', for O(log N) lookups. */
+static const uint32_t sorted_message_ids[DBC_MESSAGES_LEN] =
+{{
+{}
+}};
+
+static const uint16_t sorted_message_indices[DBC_MESSAGES_LEN] =
+{{
+{}
+}};
+
+/* The index of every entry in 'signals', in ascending order of signal name (as 'strcmp' orders them), for O(log N) lookups by name. */
+static const uint16_t sorted_signal_indices[DBC_SIGNALS_LEN] =
+{{
+{}
+}};
+
 
 void init_vehicle_dbc_data()
 {{
@@ -187,11 +240,18 @@ dbc_t DBC = (dbc_t)
 {{
     .messages = (const dbc_message_t *)&messages,
     .signals = (dbc_signal_t *)&signals,
+    .sorted_message_ids = sorted_message_ids,
+    .sorted_message_indices = sorted_message_indices,
+    .sorted_signal_indices = sorted_signal_indices,
 }};
 
 "#,
             struct_bodies.0,
+            decode_funcs,
             struct_bodies.1,
+            sorted_ids.0,
+            sorted_ids.1,
+            sorted_names,
             gen_src_func_init_vehicle_dbc_data(&dbc)?
         ).as_bytes()
     )?;
@@ -210,17 +270,12 @@ fn gen_src_dbc_structs(dbc: &DBC) -> Result<(String, String), Error>
 
     dbc.messages()
         .iter().for_each(|message| {
-            let parent_msg_name: String = message.message_name().chars().map(name_filter).collect();
-
             signal_freeze = signal_at;
             signal_at += message.signals().len();
 
             signals_struct_body.push_str(
                 message.signals()
                     .iter().map(|signal| {
-                        // Filter signal names too.
-                        let signal_name: String = signal.name().chars().map(name_filter).collect();
-
                         let multiplex_type: &str =
                             match signal.multiplexer_indicator() {
                                 MultiplexIndicator::MultiplexorAndMultiplexedSignal(_) => "MultiplexorAndMultiplexedSignal",
@@ -250,7 +305,7 @@ fn gen_src_dbc_structs(dbc: &DBC) -> Result<(String, String), Error>
         .parent_message = (dbc_message_t *)&messages[{msg_index}],
         .widget_instances = NULL,
         .num_widget_instances = 0,
-        .real_time_data = {{ false, 0.0f, PTHREAD_MUTEX_INITIALIZER }},
+        .real_time_data = {{ 0 }},
         .start_bit = {1},
         .signal_size = {2},
         .is_little_endian = {3},
@@ -264,7 +319,7 @@ fn gen_src_dbc_structs(dbc: &DBC) -> Result<(String, String), Error>
         .unit_text = "{11}",
         .parsed_unit_type = Unit{12:?},
     }},"#,
-                                format!("{}_{}", parent_msg_name, signal_name),
+                                signal_full_name(message, signal),
                                 signal.start_bit,
                                 signal.signal_size,
                                 matches!(signal.byte_order(), ByteOrder::LittleEndian {}),
@@ -285,11 +340,7 @@ fn gen_src_dbc_structs(dbc: &DBC) -> Result<(String, String), Error>
                     .as_str()
             );
 
-            let msg_id: u32 =
-                match message.message_id() {
-                    MessageId::Standard(i) => *i as u32,
-                    MessageId::Extended(i) => *i,
-                };
+            let msg_id: u32 = message_id_value(message);
 
             let mut signal_refs = String::new();
             for x in signal_freeze..signal_at {
@@ -303,13 +354,15 @@ fn gen_src_dbc_structs(dbc: &DBC) -> Result<(String, String), Error>
         .name = "{1}",
         .expected_length = {2},
         .signals = (dbc_signal_t *[]){{{3} }},
-        .num_signals = {4}
+        .num_signals = {4},
+        .decode = decode_message_{5}
     }},"#,
                     msg_id,
                     message.message_name().chars().map(name_filter).collect::<String>(),
                     message.message_size(),
                     signal_refs,
                     signal_at - signal_freeze,
+                    msg_index,
                 ).as_str()
             );
 
@@ -320,6 +373,209 @@ fn gen_src_dbc_structs(dbc: &DBC) -> Result<(String, String), Error>
 }
 
 
+/*
+ * Builds the C expression that extracts a signal's raw (unscaled) value from the 'data' payload.
+ *  Bit positions follow the same convention as the generic 'store_signal_value' in canbus.c: Intel
+ *  signals count up from the LSB of byte 0, Motorola signals are read MSB-first from 'start_bit'.
+ *  Everything is resolved here, so the C side is one or two 64-bit loads, a shift and a mask.
+ */
+fn gen_src_extract_expr(signal: &Signal, message_size: u64) -> String
+{
+    let start = signal.start_bit;
+    let size = signal.signal_size;
+
+    // Pick the load window. Messages up to 8 bytes share a single load at byte 0 across all their
+    //  signals; larger (FD) payloads load from the signal's own byte, kept inside the payload.
+    let base = std::cmp::min(start / 8, std::cmp::max(message_size, 8) - 8);
+    let shift = start - (base * 8);
+
+    let mask = if size >= 64 {
+        String::from("0xFFFFFFFFFFFFFFFFull")
+    } else {
+        format!("0x{:X}ull", (1u64 << size) - 1)
+    };
+
+    // Signals over 56 bits can straddle two words. The second load is kept inside the payload as well,
+    //  so it can overlap the end of the first; the overlapping bits are shifted back out.
+    let next_base = std::cmp::min(base + 8, std::cmp::max(message_size, 8) - 8);
+    let overlap_bits = (base + 8 - next_base) * 8;
+
+    match signal.byte_order() {
+        ByteOrder::LittleEndian => {
+            if shift + size <= 64 {
+                format!("((load_le64(&data[{}]) >> {}) & {})", base, shift, mask)
+            } else {
+                format!(
+                    "(((load_le64(&data[{0}]) >> {1}) | ((load_le64(&data[{2}]) >> {3}) << {4})) & {5})",
+                    base, shift, next_base, overlap_bits, 64 - shift, mask
+                )
+            }
+        },
+        ByteOrder::BigEndian => {
+            if shift + size <= 64 {
+                format!("((load_be64(&data[{}]) >> {}) & {})", base, 64 - shift - size, mask)
+            } else {
+                format!(
+                    "(((load_be64(&data[{0}]) << {1}) | ((load_be64(&data[{2}]) << {3}) >> {4})) & {5})",
+                    base, shift + size - 64, next_base, overlap_bits, 128 - shift - size, mask
+                )
+            }
+        },
+    }
+}
+
+
+fn gen_src_publish_stmt(signal_index: usize, signal: &Signal, raw_expr: &str, indent: &str) -> String
+{
+    format!(
+        "{0}changed |= signal_publish(&signals[{1}], CLAMP(({2} + ((double){3} * {4})), {5}, {6}));\n",
+        indent,
+        signal_index,
+        signal.offset,
+        raw_expr,
+        signal.factor,
+        signal.min,
+        signal.max
+    )
+}
+
+
+/*
+ * Emits one decoder per message. Multiplexed messages decode their multiplexor first and then
+ *  dispatch on its raw value, so only the signals of the active mux page are ever extracted.
+ *  Extended multiplexing (MultiplexorAndMultiplexedSignal) is treated as a plain page of the
+ *  message's primary multiplexor.
+ */
+fn gen_src_decode_funcs(dbc: &DBC) -> Result<String, Error>
+{
+    let mut decode_funcs = String::new();
+    let mut signal_at = 0;
+
+    for (msg_index, message) in dbc.messages().iter().enumerate() {
+        let message_size = *message.message_size();
+        let mut body = String::from("    bool changed = false;\n");
+        let mut mux_pages: BTreeMap<u64, String> = BTreeMap::new();
+
+        // 'gen_src_extract_expr' shifts by up to 64 minus what lies outside the payload, so a signal
+        //  reaching past it (or wider than a load) would come out as an undefined shift in C.
+        for signal in message.signals().iter() {
+            if signal.signal_size == 0 || signal.signal_size > 64
+                || signal.start_bit + signal.signal_size > message_size * 8 {
+                return Err(Error::other(format!(
+                    "Signal '{}' ({} bits at bit {}) does not fit in the {}-byte message '{}'.",
+                    signal.name(), signal.signal_size, signal.start_bit, message_size, message.message_name()
+                )));
+            }
+        }
+
+        let multiplexor = message.signals().iter().position(
+            |signal| matches!(signal.multiplexer_indicator(), MultiplexIndicator::Multiplexor)
+        );
+
+        if let Some(mux_index) = multiplexor {
+            let mux_signal = &message.signals()[mux_index];
+
+            body.push_str(
+                &format!("    const uint64_t mux = {};\n", gen_src_extract_expr(mux_signal, message_size))
+            );
+            body.push_str(&gen_src_publish_stmt(signal_at + mux_index, mux_signal, "mux", "    "));
+        }
+
+        for (sig_index, signal) in message.signals().iter().enumerate() {
+            let raw_expr = gen_src_extract_expr(signal, message_size);
+
+            match signal.multiplexer_indicator() {
+                MultiplexIndicator::Multiplexor => {},
+                MultiplexIndicator::MultiplexedSignal(page)
+                | MultiplexIndicator::MultiplexorAndMultiplexedSignal(page) if multiplexor.is_some() => {
+                    mux_pages.entry(*page).or_default().push_str(
+                        &gen_src_publish_stmt(signal_at + sig_index, signal, &raw_expr, "            ")
+                    );
+                },
+                _ => body.push_str(&gen_src_publish_stmt(signal_at + sig_index, signal, &raw_expr, "    ")),
+            }
+        }
+
+        if !mux_pages.is_empty() {
+            body.push_str("    switch (mux) {\n");
+            for (page, page_body) in mux_pages.iter() {
+                body.push_str(&format!("        case {}:\n{}            break;\n", page, page_body));
+            }
+            body.push_str("        default: break;\n    }\n");
+        }
+
+        signal_at += message.signals().len();
+
+        decode_funcs.push_str(
+            &format!(
+                r#"/* {0} */
+static bool decode_message_{1}(const uint8_t *data)
+{{
+{2}
+    return changed;
+}}
+
+"#,
+                message.message_name().chars().map(name_filter).collect::<String>(),
+                msg_index,
+                body
+            )
+        );
+    }
+
+    Ok(decode_funcs)
+}
+
+
+fn message_id_value(message: &Message) -> u32
+{
+    match message.message_id() {
+        MessageId::Standard(i) => *i as u32,
+        MessageId::Extended(i) => *i,
+    }
+}
+
+
+fn gen_src_sorted_message_ids(dbc: &DBC) -> Result<(String, String), Error>
+{
+    if dbc.messages().len() > u16::MAX as usize {
+        return Err(Error::other("Too many DBC messages to index (max 65535)."));
+    }
+
+    let mut sorted: Vec<(u32, usize)> = dbc.messages()
+        .iter()
+        .enumerate()
+        .map(|(index, message)| (message_id_value(message), index))
+        .collect();
+    sorted.sort();
+
+    let ids = sorted.iter().map(|(id, _)| format!("    0x{:x},", id)).collect::<Vec<String>>().join("\n");
+    let indices = sorted.iter().map(|(_, index)| format!("    {},", index)).collect::<Vec<String>>().join("\n");
+
+    Ok((ids, indices))
+}
+
+
+fn gen_src_sorted_signal_names(dbc: &DBC) -> Result<String, Error>
+{
+    if dbc.signals().len() > u16::MAX as usize {
+        return Err(Error::other("Too many DBC signals to index (max 65535)."));
+    }
+
+    // Same names as 'gen_src_dbc_structs' gives them. Rust compares strings bytewise, just like
+    //  'strcmp'; equal names keep their 'signals' order, so a lookup finds the first one.
+    let mut sorted: Vec<(String, usize)> = dbc.messages()
+        .iter()
+        .flat_map(|message| message.signals().iter().map(move |signal| signal_full_name(message, signal)))
+        .enumerate()
+        .map(|(index, name)| (name, index))
+        .collect();
+    sorted.sort();
+
+    Ok(sorted.iter().map(|(_, index)| format!("    {},", index)).collect::<Vec<String>>().join("\n"))
+}
+
+
 fn gen_src_func_init_vehicle_dbc_data(dbc: &DBC) -> Result<String, Error>
 {
 //     let mut init_func_body = String::new();